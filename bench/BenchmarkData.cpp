@@ -0,0 +1,92 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include "BenchmarkData.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace pulse {
+	namespace bench {
+		void fillRandom(std::vector<double>& values, double min, double max, unsigned int seed) {
+			//simple LCG so the data does not depend on the standard library implementation
+			unsigned long state = seed;
+			std::vector<double>::iterator it;
+			for (it = values.begin(); it != values.end(); it++) {
+				state = (state*6364136223846793005UL + 1442695040888963407UL);
+				double r = static_cast<double>(state >> 11)/static_cast<double>(1UL << 53);
+				*it = min + (max-min)*r;
+			}
+		}
+		
+		BenchmarkPatterns::BenchmarkPatterns(size_t numPatterns, size_t numInputs, size_t numTargets) :
+			m_inputs(numPatterns*numInputs),
+			m_targets(numPatterns*numTargets),
+			m_inputRows(numPatterns),
+			m_targetRows(numPatterns)
+		{
+			fillRandom(m_inputs, -10.0, 10.0, 1);
+			fillRandom(m_targets, -1.0, 1.0, 2);
+			m_originalInputs = m_inputs;
+			m_originalTargets = m_targets;
+			for (size_t i = 0; i < numPatterns; i++) {
+				m_inputRows[i] = &m_inputs[i*numInputs];
+				m_targetRows[i] = &m_targets[i*numTargets];
+			}
+			m_patternSet.pattern_count = numPatterns;
+			m_patternSet.input_count = numInputs;
+			m_patternSet.target_count = numTargets;
+			m_patternSet.input = &m_inputRows[0];
+			m_patternSet.target = &m_targetRows[0];
+		}
+		NPP2::PatternSet& BenchmarkPatterns::patternSet() {
+			return m_patternSet;
+		}
+		double** BenchmarkPatterns::inputRows() {
+			return &m_inputRows[0];
+		}
+		void BenchmarkPatterns::restore() {
+			std::copy(m_originalInputs.begin(), m_originalInputs.end(), m_inputs.begin());
+			std::copy(m_originalTargets.begin(), m_originalTargets.end(), m_targets.begin());
+		}
+		size_t BenchmarkPatterns::numValues() const {
+			return m_inputs.size() + m_targets.size();
+		}
+		
+		std::string temporaryFile(const std::string& name) {
+			const char* dir = getenv("TMPDIR");
+			return std::string(dir ? dir : "/tmp") + "/pulse_bench_" + name;
+		}
+	}
+}
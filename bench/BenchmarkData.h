@@ -0,0 +1,78 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <npp2.h>
+#include <PatternSet.h>
+
+namespace pulse {
+	namespace bench {
+		/** Fills a vector with reproducible uniformly distributed values in [min, max) */
+		void fillRandom(std::vector<double>& values, double min, double max, unsigned int seed);
+		
+		/** Owns random patterns and exposes them as NPP2::PatternSet.
+		 *  As PatternScaler scales in place, restore() copies the original values back.
+		 */
+		class BenchmarkPatterns {
+		public:
+			BenchmarkPatterns(size_t numPatterns, size_t numInputs, size_t numTargets);
+			/** Returns the PatternSet that points to the owned data */
+			NPP2::PatternSet& patternSet();
+			/** Returns the rows of the input data, each row contains numInputs values */
+			double** inputRows();
+			/** Copies the original values back */
+			void restore();
+			/** Number of input and target values of all patterns */
+			size_t numValues() const;
+		private:
+			BenchmarkPatterns(const BenchmarkPatterns&);
+			BenchmarkPatterns& operator=(const BenchmarkPatterns&);
+			
+			std::vector<double> m_inputs;
+			std::vector<double> m_targets;
+			std::vector<double> m_originalInputs;
+			std::vector<double> m_originalTargets;
+			std::vector<double*> m_inputRows;
+			std::vector<double*> m_targetRows;
+			NPP2::PatternSet m_patternSet;
+		};
+		
+		/** Returns a path for temporary benchmark files */
+		std::string temporaryFile(const std::string& name);
+	}
+}
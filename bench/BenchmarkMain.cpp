@@ -0,0 +1,70 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* pulse_benchmark - runs all benchmarks of the bench directory.
+ *
+ * Unless --benchmark_out is given, the results are additionally written as JSON
+ * into pulse_benchmark.json so they can be compared between versions
+ * (e.g. with compare.py of Google Benchmark).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+	std::vector<char*> args(argv, argv+argc);
+	bool hasOut = false;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+			hasOut = true;
+		}
+	}
+	std::string out("--benchmark_out=pulse_benchmark.json");
+	std::string format("--benchmark_out_format=json");
+	if (!hasOut) {
+		args.push_back(&out[0]);
+		args.push_back(&format[0]);
+	}
+	int numArgs = static_cast<int>(args.size());
+	benchmark::Initialize(&numArgs, &args[0]);
+	if (benchmark::ReportUnrecognizedArguments(numArgs, &args[0])) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* Throughput of CSVReader on tab separated numeric files. */
+
+#include <benchmark/benchmark.h>
+
+#include <pulse/CSVReader.h>
+
+#include "BenchmarkData.h"
+
+#include <fstream>
+
+namespace {
+	using namespace pulse;
+	
+	/** Writes numLines lines with numColumns random values, returns the size of the file */
+	size_t writeNumericFile(const std::string& filename, size_t numLines, size_t numColumns) {
+		std::vector<double> values(numLines*numColumns);
+		bench::fillRandom(values, -1000.0, 1000.0, 4);
+		std::ofstream out(filename.c_str(), std::ios_base::out | std::fstream::trunc);
+		out.precision(17);
+		for (size_t i = 0; i < numLines; i++) {
+			for (size_t j = 0; j < numColumns; j++) {
+				if (j != 0) {
+					out<<'\t';
+				}
+				out<<values[i*numColumns+j];
+			}
+			out<<'\n';
+		}
+		return static_cast<size_t>(out.tellp());
+	}
+	
+	void BM_CSVReaderReadLine(benchmark::State& state) {
+		const size_t numLines = state.range(0);
+		const size_t numColumns = state.range(1);
+		const std::string filename = bench::temporaryFile("csv.txt");
+		const size_t bytes = writeNumericFile(filename, numLines, numColumns);
+		for (auto _ : state) {
+			CSVReader reader(filename);
+			std::vector<double> line;
+			for (size_t i = 0; i < numLines; i++) {
+				line.clear();
+				reader.readLine(line);
+			}
+			benchmark::DoNotOptimize(line.data());
+		}
+		state.SetItemsProcessed(state.iterations()*numLines*numColumns);
+		state.SetBytesProcessed(state.iterations()*bytes);
+	}
+	BENCHMARK(BM_CSVReaderReadLine)
+		->ArgNames({"lines", "columns"})
+		->Args({1<<12, 8})
+		->Args({1<<10, 128})
+		->Args({16, 1<<13});
+	
+	void BM_CSVReaderReadEntries(benchmark::State& state) {
+		const size_t numLines = state.range(0);
+		const size_t numColumns = state.range(1);
+		const std::string filename = bench::temporaryFile("csv.txt");
+		const size_t bytes = writeNumericFile(filename, numLines, numColumns);
+		for (auto _ : state) {
+			CSVReader reader(filename);
+			std::vector<double> line;
+			for (size_t i = 0; i < numLines; i++) {
+				line.clear();
+				reader.readEntries(numColumns, line);
+			}
+			benchmark::DoNotOptimize(line.data());
+		}
+		state.SetItemsProcessed(state.iterations()*numLines*numColumns);
+		state.SetBytesProcessed(state.iterations()*bytes);
+	}
+	BENCHMARK(BM_CSVReaderReadEntries)
+		->ArgNames({"lines", "columns"})
+		->Args({1<<12, 8})
+		->Args({1<<10, 128})
+		->Args({16, 1<<13});
+}
@@ -0,0 +1,275 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* pulse_latency - tail latency of the single sample inference path.
+ *
+ * Measures every single call of PatternScaler::scaleInput, originalTargetValues,
+ * scaleInput followed by originalTargetValues and copyAndScaleInput and reports
+ * p50/p99/p99.9/max and the number of heap allocations per call.
+ *
+ * usage: pulse_latency [--iterations=N] [--inputs=16,64,...] [--targets=N] [--json=file]
+ *
+ * With --json every result is appended as one JSON object per line, so the
+ * results of several runs can be tracked over time.
+ */
+
+#include <pulse/PatternScaler.h>
+#include <pulse/Normalize.h>
+#include <pulse/NormalizeWithFixpoint.h>
+
+#include "BenchmarkData.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+//the replaced operator new below returns memory from malloc, which gcc does not know
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+	std::atomic<unsigned long> g_allocations(0);
+}
+
+//count all heap allocations of the process
+void* operator new(size_t size) {
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+void operator delete(void* p) noexcept {
+	free(p);
+}
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+namespace {
+	using namespace pulse;
+	typedef std::chrono::steady_clock Clock;
+	
+	struct Result {
+		std::string operation;
+		size_t numInputs;
+		size_t numTargets;
+		bench::LatencyHistogram histogram;
+		unsigned long allocations;
+	};
+	
+	PatternScaler makePatternScaler(size_t numInputs, size_t numTargets) {
+		PatternScaler scaler;
+		for (size_t i = 0; i < numInputs; i++) {
+			if (i % 4 == 0) {
+				scaler.addInputScaler(NormalizeWithFixpoint(0.0, 0.5, 0.0, 1.0));
+			} else {
+				scaler.addInputScaler(Normalize(0.0, 1.0));
+			}
+		}
+		for (size_t i = 0; i < numTargets; i++) {
+			scaler.addTargetScaler(Normalize(-1.0, 1.0));
+		}
+		return scaler;
+	}
+	
+	/** Measures op(sample) for iterations samples, the sample is restored from the source data before each call (not measured) */
+	template<class Op>
+	void measure(Result& result, const std::vector<double>& source, size_t dims, size_t iterations, Op op) {
+		const size_t numSamples = source.size()/dims;
+		std::vector<double> sample(dims);
+		//warm up caches and branch predictors
+		for (size_t i = 0; i < iterations/10 + 1; i++) {
+			memcpy(&sample[0], &source[(i%numSamples)*dims], dims*sizeof(double));
+			op(&sample[0]);
+		}
+		unsigned long allocations = 0;
+		for (size_t i = 0; i < iterations; i++) {
+			memcpy(&sample[0], &source[(i%numSamples)*dims], dims*sizeof(double));
+			unsigned long allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+			Clock::time_point start = Clock::now();
+			op(&sample[0]);
+			Clock::time_point end = Clock::now();
+			allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+			result.histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count());
+		}
+		result.allocations = allocations;
+	}
+	
+	void print(const Result& r) {
+		const bench::LatencyHistogram& h = r.histogram;
+		printf("%-32s %7lu %7lu %9.1f %9lu %9lu %9lu %9lu %9.3f\n", r.operation.c_str(), (unsigned long)r.numInputs, (unsigned long)r.numTargets, h.mean(), h.percentile(0.5), h.percentile(0.99), h.percentile(0.999), h.max(), (double)r.allocations/(double)h.count());
+	}
+	
+	void appendJson(std::ofstream& out, const Result& r, const std::string& timestamp) {
+		const bench::LatencyHistogram& h = r.histogram;
+		out<<"{\"timestamp\":\""<<timestamp<<"\",\"operation\":\""<<r.operation<<"\""
+			<<",\"inputs\":"<<r.numInputs<<",\"targets\":"<<r.numTargets
+			<<",\"calls\":"<<h.count()<<",\"mean_ns\":"<<h.mean()
+			<<",\"p50_ns\":"<<h.percentile(0.5)<<",\"p99_ns\":"<<h.percentile(0.99)
+			<<",\"p999_ns\":"<<h.percentile(0.999)<<",\"max_ns\":"<<h.max()
+			<<",\"allocations_per_call\":"<<(double)r.allocations/(double)h.count()<<"}\n";
+	}
+	
+	std::vector<size_t> parseList(const char* str) {
+		std::vector<size_t> re;
+		std::stringstream sstr(str);
+		std::string item;
+		while (std::getline(sstr, item, ',')) {
+			re.push_back(atol(item.c_str()));
+		}
+		return re;
+	}
+}
+
+int main(int argc, char** argv) {
+	size_t iterations = 200000;
+	size_t numTargets = 4;
+	std::vector<size_t> inputDims;
+	inputDims.push_back(16);
+	inputDims.push_back(64);
+	inputDims.push_back(256);
+	inputDims.push_back(1024);
+	std::string jsonFile;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--iterations=", 13) == 0) {
+			iterations = atol(argv[i]+13);
+		} else if (strncmp(argv[i], "--inputs=", 9) == 0) {
+			inputDims = parseList(argv[i]+9);
+		} else if (strncmp(argv[i], "--targets=", 10) == 0) {
+			numTargets = atol(argv[i]+10);
+		} else if (strncmp(argv[i], "--json=", 7) == 0) {
+			jsonFile = argv[i]+7;
+		} else {
+			std::cerr<<"usage: "<<argv[0]<<" [--iterations=N] [--inputs=16,64,...] [--targets=N] [--json=file]"<<std::endl;
+			return 1;
+		}
+	}
+	if (iterations == 0 || numTargets == 0 || inputDims.empty()) {
+		std::cerr<<argv[0]<<": iterations, targets and inputs have to be > 0"<<std::endl;
+		return 1;
+	}
+	
+	std::vector<Result> results;
+	const size_t numSamples = 1024;
+	std::vector<size_t>::const_iterator it;
+	for (it = inputDims.begin(); it != inputDims.end(); it++) {
+		const size_t numInputs = *it;
+		//fit the scalers on the same data that is scaled later, so that no out of range warnings are logged
+		bench::BenchmarkPatterns patterns(numSamples, numInputs, numTargets);
+		PatternScaler scaler = makePatternScaler(numInputs, numTargets);
+		scaler.resetScalers(patterns.patternSet());
+		std::vector<double> inputs(numSamples*numInputs);
+		std::vector<double> targets(numSamples*numTargets);
+		for (size_t i = 0; i < numSamples; i++) {
+			memcpy(&inputs[i*numInputs], patterns.patternSet().input[i], numInputs*sizeof(double));
+			memcpy(&targets[i*numTargets], patterns.patternSet().target[i], numTargets*sizeof(double));
+		}
+		scaler.scaleTargets(patterns.patternSet());
+		for (size_t i = 0; i < numSamples; i++) {
+			memcpy(&targets[i*numTargets], patterns.patternSet().target[i], numTargets*sizeof(double));
+		}
+		std::vector<double> output(numTargets);
+		
+		Result r;
+		r.numInputs = numInputs;
+		r.numTargets = numTargets;
+		
+		r.operation = "scaleInput";
+		r.histogram = bench::LatencyHistogram();
+		measure(r, inputs, numInputs, iterations, [&](double* v) { scaler.scaleInput(v); });
+		results.push_back(r);
+		
+		r.operation = "originalTargetValues";
+		r.histogram = bench::LatencyHistogram();
+		measure(r, targets, numTargets, iterations, [&](double* v) { scaler.originalTargetValues(v); });
+		results.push_back(r);
+		
+		r.operation = "scaleInput+originalTargetValues";
+		r.histogram = bench::LatencyHistogram();
+		size_t sampleIndex = 0;
+		measure(r, inputs, numInputs, iterations, [&](double* v) {
+			scaler.scaleInput(v);
+			//stands in for the net: the output of the net are scaled targets
+			memcpy(&output[0], &targets[(sampleIndex++ % numSamples)*numTargets], numTargets*sizeof(double));
+			scaler.originalTargetValues(&output[0]);
+		});
+		results.push_back(r);
+		
+		r.operation = "copyAndScaleInput";
+		r.histogram = bench::LatencyHistogram();
+		measure(r, inputs, numInputs, iterations, [&](double* v) {
+			double* scaled = scaler.copyAndScaleInput(v);
+			v[0] = scaled[0];
+			delete[] scaled;
+		});
+		results.push_back(r);
+	}
+	
+	printf("%-32s %7s %7s %9s %9s %9s %9s %9s %9s\n", "operation", "inputs", "targets", "mean[ns]", "p50[ns]", "p99[ns]", "p99.9[ns]", "max[ns]", "allocs");
+	std::vector<Result>::const_iterator rit;
+	for (rit = results.begin(); rit != results.end(); rit++) {
+		print(*rit);
+	}
+	
+	if (!jsonFile.empty()) {
+		std::ofstream out(jsonFile.c_str(), std::ios_base::out | std::ios_base::app);
+		if (!out.good()) {
+			std::cerr<<argv[0]<<": could not open "<<jsonFile<<std::endl;
+			return 1;
+		}
+		char timestamp[32];
+		time_t now = time(0);
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+		for (rit = results.begin(); rit != results.end(); rit++) {
+			appendJson(out, *rit, timestamp);
+		}
+	}
+	return 0;
+}
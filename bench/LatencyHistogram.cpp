@@ -0,0 +1,105 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include "LatencyHistogram.h"
+
+#include <cassert>
+
+namespace pulse {
+	namespace bench {
+		LatencyHistogram::LatencyHistogram() :
+			m_buckets((sizeof(unsigned long)*8 + 1) << subBucketBits, 0),
+			m_count(0),
+			m_max(0),
+			m_sum(0.0)
+		{
+		
+		}
+		size_t LatencyHistogram::bucketIndex(unsigned long value) {
+			const unsigned long subBuckets = 1UL << subBucketBits;
+			if (value < subBuckets) {
+				//values below 2^subBucketBits are recorded exactly
+				return value;
+			}
+			unsigned int magnitude = 0;
+			while ((value >> magnitude) >= 2*subBuckets) {
+				magnitude++;
+			}
+			//value >> magnitude is in [subBuckets, 2*subBuckets)
+			return (magnitude+1)*subBuckets + ((value >> magnitude) - subBuckets);
+		}
+		unsigned long LatencyHistogram::bucketUpperBound(size_t index) {
+			const unsigned long subBuckets = 1UL << subBucketBits;
+			if (index < subBuckets) {
+				return index;
+			}
+			unsigned long magnitude = index/subBuckets - 1;
+			unsigned long sub = index%subBuckets + subBuckets;
+			return ((sub+1) << magnitude) - 1;
+		}
+		void LatencyHistogram::record(unsigned long nanoseconds) {
+			m_buckets[bucketIndex(nanoseconds)]++;
+			m_count++;
+			m_sum += static_cast<double>(nanoseconds);
+			if (nanoseconds > m_max) {
+				m_max = nanoseconds;
+			}
+		}
+		unsigned long LatencyHistogram::percentile(double p) const {
+			assert(m_count > 0);
+			size_t rank = static_cast<size_t>(p*static_cast<double>(m_count) + 0.5);
+			if (rank < 1) {
+				rank = 1;
+			}
+			size_t seen = 0;
+			for (size_t i = 0; i < m_buckets.size(); i++) {
+				seen += m_buckets[i];
+				if (seen >= rank) {
+					unsigned long bound = bucketUpperBound(i);
+					return (bound < m_max) ? bound : m_max;
+				}
+			}
+			return m_max;
+		}
+		unsigned long LatencyHistogram::max() const {
+			return m_max;
+		}
+		double LatencyHistogram::mean() const {
+			return (m_count > 0) ? m_sum/static_cast<double>(m_count) : 0.0;
+		}
+		size_t LatencyHistogram::count() const {
+			return m_count;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <vector>
+#include <cstddef>
+
+namespace pulse {
+	namespace bench {
+		/** Histogram of latencies in nanoseconds with a bounded relative error.
+		 *  Values are grouped by their power of two and each power of two is split into 2^subBucketBits linear sub buckets (relative error < 2^-subBucketBits).
+		 */
+		class LatencyHistogram {
+		public:
+			LatencyHistogram();
+			/** Adds a single measurement */
+			void record(unsigned long nanoseconds);
+			/** Returns the value below which the fraction p of all measurements lies (upper bound of the bucket)
+			 *  \pre count() > 0
+			 *  \param p in [0,1]
+			 */
+			unsigned long percentile(double p) const;
+			/** Returns the largest recorded value (exact) */
+			unsigned long max() const;
+			/** Returns the mean of all recorded values */
+			double mean() const;
+			/** Returns the number of recorded values */
+			size_t count() const;
+		private:
+			static const unsigned int subBucketBits = 5;
+			static size_t bucketIndex(unsigned long value);
+			static unsigned long bucketUpperBound(size_t index);
+			
+			std::vector<size_t> m_buckets;
+			size_t m_count;
+			unsigned long m_max;
+			double m_sum;
+		};
+	}
+}
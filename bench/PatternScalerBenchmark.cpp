@@ -0,0 +1,396 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* Benchmarks of PatternScaler on PatternSets of different shapes and of the
+ * saving and loading of scaler files with a growing number of dimensions.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <pulse/PatternScaler.h>
+#include <pulse/Normalize.h>
+#include <pulse/NormalizeWithFixpoint.h>
+#include <pulse/PatternQuantizer.h>
+#include <pulse/InternedPatternScaler.h>
+
+#include "BenchmarkData.h"
+
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+	using namespace pulse;
+	
+	/** Every fourth input uses a fixpoint, the targets are normalized */
+	PatternScaler makePatternScaler(size_t numInputs, size_t numTargets) {
+		PatternScaler scaler;
+		for (size_t i = 0; i < numInputs; i++) {
+			if (i % 4 == 0) {
+				scaler.addInputScaler(NormalizeWithFixpoint(0.0, 0.5, 0.0, 1.0));
+			} else {
+				scaler.addInputScaler(Normalize(0.0, 1.0));
+			}
+		}
+		for (size_t i = 0; i < numTargets; i++) {
+			scaler.addTargetScaler(Normalize(-1.0, 1.0));
+		}
+		return scaler;
+	}
+	
+	size_t fileSize(const std::string& filename) {
+		std::ifstream in(filename.c_str(), std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+		return static_cast<size_t>(in.tellg());
+	}
+	
+	void BM_PatternScalerScale(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		const size_t numTargets = 1;
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, numTargets);
+		PatternScaler scaler = makePatternScaler(numInputs, numTargets);
+		scaler.resetScalers(patterns.patternSet());
+		for (auto _ : state) {
+			scaler.scale(patterns.patternSet());
+			benchmark::ClobberMemory();
+			state.PauseTiming();
+			patterns.restore();
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(state.iterations()*patterns.numValues());
+		state.SetBytesProcessed(state.iterations()*patterns.numValues()*2*sizeof(double));
+	}
+	BENCHMARK(BM_PatternScalerScale)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024})
+		->Args({16, 1<<14});
+	
+	void BM_PatternScalerReset(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, 1);
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		for (auto _ : state) {
+			scaler.resetScalers(patterns.patternSet());
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*patterns.numValues());
+		state.SetBytesProcessed(state.iterations()*patterns.numValues()*sizeof(double));
+	}
+	BENCHMARK(BM_PatternScalerReset)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024});
+	
+	void BM_PatternScalerRescale(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, 1);
+		PatternScaler previous = makePatternScaler(numInputs, 1);
+		previous.resetScalers(patterns.patternSet());
+		//the ranges of the current scalers are wider, so every dimension changes
+		PatternScaler scaler = previous;
+		std::vector<double> values(numInputs, 1e3);
+		scaler.updateInputScalers(values, 0);
+		previous.scale(patterns.patternSet());
+		for (auto _ : state) {
+			scaler.rescale(previous, patterns.patternSet());
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*patterns.numValues());
+		state.SetBytesProcessed(state.iterations()*patterns.numValues()*2*sizeof(double));
+	}
+	BENCHMARK(BM_PatternScalerRescale)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024});
+	
+	void BM_PatternScalerScaleFloats(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, 1);
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		scaler.resetScalers(patterns.patternSet());
+		std::vector<float> values(numPatterns*numInputs);
+		for (auto _ : state) {
+			scaler.scaleInputs(&values[0], numPatterns);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*values.size());
+		state.SetBytesProcessed(state.iterations()*values.size()*2*sizeof(float));
+	}
+	BENCHMARK(BM_PatternScalerScaleFloats)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024});
+	
+	void BM_PatternScalerScaleToFloats(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, 1);
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		scaler.resetScalers(patterns.patternSet());
+		std::vector<float> values(numPatterns*numInputs);
+		for (auto _ : state) {
+			scaler.scaleInputs(patterns.patternSet(), &values[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*values.size());
+		state.SetBytesProcessed(state.iterations()*values.size()*(sizeof(double)+sizeof(float)));
+	}
+	BENCHMARK(BM_PatternScalerScaleToFloats)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024});
+	
+	void BM_PatternQuantizerQuantize(benchmark::State& state) {
+		const size_t numPatterns = state.range(0);
+		const size_t numInputs = state.range(1);
+		bench::BenchmarkPatterns patterns(numPatterns, numInputs, 1);
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		scaler.resetScalers(patterns.patternSet());
+		PatternQuantizer quantizer(scaler, 8);
+		std::vector<int8_t> values(numPatterns*numInputs);
+		for (auto _ : state) {
+			quantizer.quantizeInputs(patterns.patternSet(), &values[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*values.size());
+		state.SetBytesProcessed(state.iterations()*values.size()*(sizeof(double)+sizeof(int8_t)));
+	}
+	BENCHMARK(BM_PatternQuantizerQuantize)
+		->ArgNames({"patterns", "inputs"})
+		->Args({1<<16, 4})
+		->Args({1<<16, 16})
+		->Args({1<<14, 64})
+		->Args({1<<12, 256})
+		->Args({1<<10, 1024});
+	
+	/** One-hot layout: 16 dense inputs followed by 0/1 inputs, which all get the same Normalize parameters */
+	PatternScaler makeOneHotScaler(size_t numInputs, std::vector<double>& sample) {
+		const size_t numDense = 16;
+		bench::BenchmarkPatterns patterns(2, numInputs, 1);
+		NPP2::PatternSet& patternSet = patterns.patternSet();
+		for (size_t i = numDense; i < numInputs; i++) {
+			patternSet.input[0][i] = 0.0;
+			patternSet.input[1][i] = 1.0;
+		}
+		PatternScaler scaler = makePatternScaler(numDense, 1);
+		for (size_t i = numDense; i < numInputs; i++) {
+			scaler.addInputScaler(Normalize(0.0, 1.0));
+		}
+		scaler.resetScalers(patternSet);
+		sample.assign(patternSet.input[0], patternSet.input[0] + numInputs);
+		return scaler;
+	}
+	
+	void BM_PatternScalerScaleInputOneHot(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		std::vector<double> sample;
+		PatternScaler scaler = makeOneHotScaler(numInputs, sample);
+		std::vector<double> values(numInputs);
+		for (auto _ : state) {
+			values = sample;
+			scaler.scaleInput(&values[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*numInputs);
+	}
+	BENCHMARK(BM_PatternScalerScaleInputOneHot)->ArgName("inputs")->RangeMultiplier(8)->Range(64, 1<<15);
+	
+	void BM_InternedPatternScalerScaleInputOneHot(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		std::vector<double> sample;
+		PatternScaler scaler = makeOneHotScaler(numInputs, sample);
+		ScalingTable table;
+		InternedPatternScaler interned(scaler, table);
+		std::vector<double> values(numInputs);
+		for (auto _ : state) {
+			values = sample;
+			interned.scaleInput(&values[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*numInputs);
+		state.counters["functions"] = static_cast<double>(table.size());
+	}
+	BENCHMARK(BM_InternedPatternScalerScaleInputOneHot)->ArgName("inputs")->RangeMultiplier(8)->Range(64, 1<<15);
+	
+	/** 64 sparse samples in the CSR format with numInputs/64 non-zeros each, items are the stored values */
+	void BM_PatternScalerScaleInputsSparse(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		const size_t numSamples = 64;
+		const size_t numValues = numInputs/64;
+		//the values are in [0,1], so they only touch the one hot dimensions which were fitted to this range
+		const size_t numDense = 16;
+		std::vector<double> sample;
+		PatternScaler scaler = makeOneHotScaler(numInputs, sample);
+		std::vector<size_t> rowStart(1, 0);
+		std::vector<size_t> indices;
+		for (size_t i = 0; i < numSamples; i++) {
+			for (size_t k = 0; k < numValues; k++) {
+				indices.push_back(numDense + (i + k*64) % (numInputs - numDense));
+			}
+			rowStart.push_back(indices.size());
+		}
+		std::vector<double> sparse(indices.size());
+		bench::fillRandom(sparse, 0.0, 1.0, 7);
+		std::vector<double> values(sparse.size());
+		for (auto _ : state) {
+			values = sparse;
+			scaler.scaleInputs(&rowStart[0], &indices[0], &values[0], numSamples);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*indices.size());
+	}
+	BENCHMARK(BM_PatternScalerScaleInputsSparse)->ArgName("inputs")->RangeMultiplier(8)->Range(64, 1<<15);
+	
+	void BM_PatternScalerUpdateSample(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		const size_t numSamples = 64;
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		std::vector<double> samples(numSamples*numInputs);
+		bench::fillRandom(samples, -10.0, 10.0, 5);
+		std::vector<std::vector<double> > rows;
+		for (size_t i = 0; i < numSamples; i++) {
+			rows.push_back(std::vector<double>(samples.begin() + i*numInputs, samples.begin() + (i+1)*numInputs));
+		}
+		size_t i = 0;
+		for (auto _ : state) {
+			scaler.updateInputScalers(rows[i], 0);
+			i = (i + 1) % numSamples;
+		}
+		state.SetItemsProcessed(state.iterations()*numInputs);
+		state.SetBytesProcessed(state.iterations()*numInputs*sizeof(double));
+	}
+	BENCHMARK(BM_PatternScalerUpdateSample)->ArgName("inputs")->RangeMultiplier(8)->Range(16, 1<<12);
+	
+	/** Every thread feeds single samples of 16 inputs, once through a mutex around the PatternScaler and once through a ConcurrentRangeAccumulator */
+	const size_t concurrentInputs = 16;
+	
+	std::vector<double> makeSamples(size_t numSamples, int seed) {
+		std::vector<double> samples(numSamples*concurrentInputs);
+		bench::fillRandom(samples, -10.0, 10.0, seed);
+		return samples;
+	}
+	
+	void BM_PatternScalerUpdateLocked(benchmark::State& state) {
+		static PatternScaler* scaler = 0;
+		static std::mutex mutex;
+		if (state.thread_index() == 0) {
+			scaler = new PatternScaler(makePatternScaler(concurrentInputs, 1));
+		}
+		const std::vector<double> samples = makeSamples(1024, state.thread_index() + 1);
+		std::vector<double> values(concurrentInputs);
+		size_t i = 0;
+		for (auto _ : state) {
+			values.assign(samples.begin() + i*concurrentInputs, samples.begin() + (i+1)*concurrentInputs);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				scaler->updateInputScalers(values, 0);
+			}
+			i = (i + 1) % 1024;
+		}
+		if (state.thread_index() == 0) {
+			delete scaler;
+		}
+		state.SetItemsProcessed(state.iterations()*concurrentInputs);
+	}
+	BENCHMARK(BM_PatternScalerUpdateLocked)->ThreadRange(1, 8)->UseRealTime();
+	
+	void BM_ConcurrentRangeAccumulatorUpdate(benchmark::State& state) {
+		static ConcurrentRangeAccumulator* accumulator = 0;
+		if (state.thread_index() == 0) {
+			accumulator = new ConcurrentRangeAccumulator(concurrentInputs, state.threads());
+		}
+		const std::vector<double> samples = makeSamples(1024, state.thread_index() + 1);
+		std::vector<double> values(concurrentInputs);
+		size_t i = 0;
+		for (auto _ : state) {
+			values.assign(samples.begin() + i*concurrentInputs, samples.begin() + (i+1)*concurrentInputs);
+			accumulator->update(state.thread_index(), &values[0], 0, concurrentInputs);
+			i = (i + 1) % 1024;
+		}
+		if (state.thread_index() == 0) {
+			delete accumulator;
+		}
+		state.SetItemsProcessed(state.iterations()*concurrentInputs);
+	}
+	BENCHMARK(BM_ConcurrentRangeAccumulatorUpdate)->ThreadRange(1, 8)->UseRealTime();
+	
+	void BM_PatternScalerSaveToFile(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		bench::BenchmarkPatterns patterns(64, numInputs, 1);
+		PatternScaler scaler = makePatternScaler(numInputs, 1);
+		scaler.resetScalers(patterns.patternSet());
+		const std::string filename = bench::temporaryFile("save.txt");
+		for (auto _ : state) {
+			scaler.saveToFile(filename);
+		}
+		state.SetItemsProcessed(state.iterations()*(numInputs+1));
+		state.SetBytesProcessed(state.iterations()*fileSize(filename));
+	}
+	BENCHMARK(BM_PatternScalerSaveToFile)->ArgName("dimensions")->RangeMultiplier(4)->Range(4, 1<<10);
+	
+	void BM_PatternScalerLoadFromFile(benchmark::State& state) {
+		const size_t numInputs = state.range(0);
+		bench::BenchmarkPatterns patterns(64, numInputs, 1);
+		PatternScaler saved = makePatternScaler(numInputs, 1);
+		saved.resetScalers(patterns.patternSet());
+		const std::string filename = bench::temporaryFile("load.txt");
+		saved.saveToFile(filename);
+		PatternScaler scaler;
+		for (auto _ : state) {
+			scaler.loadFromFile(filename);
+		}
+		state.SetItemsProcessed(state.iterations()*(numInputs+1));
+		state.SetBytesProcessed(state.iterations()*fileSize(filename));
+	}
+	BENCHMARK(BM_PatternScalerLoadFromFile)->ArgName("dimensions")->RangeMultiplier(4)->Range(4, 1<<10);
+}
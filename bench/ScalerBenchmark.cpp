@@ -0,0 +1,261 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* Benchmarks of the Scaler implementations on contiguous, strided and double** data.
+ * Items are scaled/fitted values, bytes are the bytes read and written by the kernel.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <limits>
+#include <pulse/Normalize.h>
+#include <pulse/NormalizeWithFixpoint.h>
+#include <pulse/ScalerChain.h>
+
+#include "BenchmarkData.h"
+
+namespace {
+	using namespace pulse;
+	
+	const size_t stride = 8;
+	
+	template<class S> S makeScaler();
+	template<> Normalize makeScaler<Normalize>() {
+		return Normalize(0.0, 1.0);
+	}
+	template<> NormalizeWithFixpoint makeScaler<NormalizeWithFixpoint>() {
+		return NormalizeWithFixpoint(0.0, 0.5, 0.0, 1.0);
+	}
+	/** Three affine stages, composed into one */
+	template<> ScalerChain makeScaler<ScalerChain>() {
+		ScalerChain chain;
+		chain.addScaler(Normalize(0.0, 1.0));
+		chain.addScaler(Normalize(-1.0, 1.0));
+		chain.addScaler(Normalize(0.0, 10.0));
+		return chain;
+	}
+	
+	/** Random values with the given stride, the scaler is fitted to them so that scaling does not log out of range values */
+	template<class S>
+	struct StridedFixture {
+		StridedFixture(size_t num, size_t offset) :
+			data(num*offset),
+			out(num*offset),
+			scaler(makeScaler<S>())
+		{
+			bench::fillRandom(data, -10.0, 10.0, 3);
+			scaler.resetScalingFactors(&data[0], offset, num);
+		}
+		std::vector<double> data;
+		std::vector<double> out;
+		S scaler;
+	};
+	
+	template<class S>
+	struct RowFixture {
+		RowFixture(size_t num) :
+			patterns(num, stride, 1),
+			scaler(makeScaler<S>())
+		{
+			scaler.resetScalingFactors(patterns.inputRows(), 0, num);
+		}
+		bench::BenchmarkPatterns patterns;
+		S scaler;
+	};
+	
+	/** Contiguous random values where every 64th value is NaN, the scaler skips and imputes them */
+	template<class S>
+	struct MissingFixture : public StridedFixture<S> {
+		MissingFixture(size_t num) :
+			StridedFixture<S>(num, 1)
+		{
+			this->scaler.setMissingValuePolicy(ImputeMissing, 0.0);
+			for (size_t i = 0; i < num; i += 64) {
+				this->data[i] = std::numeric_limits<double>::quiet_NaN();
+			}
+			this->scaler.resetScalingFactors(&this->data[0], 1, num);
+		}
+	};
+	
+	template<class S>
+	void BM_ScaleContiguous(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, 1);
+		for (auto _ : state) {
+			f.scaler.scale(&f.data[0], 1, &f.out[0], 1, num);
+			benchmark::DoNotOptimize(&f.out[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*2*sizeof(double));
+	}
+	template<class S>
+	void BM_ScaleContiguousImputing(benchmark::State& state) {
+		const size_t num = state.range(0);
+		MissingFixture<S> f(num);
+		for (auto _ : state) {
+			f.scaler.scale(&f.data[0], 1, &f.out[0], 1, num);
+			benchmark::DoNotOptimize(&f.out[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*2*sizeof(double));
+	}
+	template<class S>
+	void BM_ScaleStrided(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, stride);
+		for (auto _ : state) {
+			f.scaler.scale(&f.data[0], stride, &f.out[0], stride, num);
+			benchmark::DoNotOptimize(&f.out[0]);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*2*sizeof(double));
+	}
+	template<class S>
+	void BM_ScaleRows(benchmark::State& state) {
+		const size_t num = state.range(0);
+		RowFixture<S> f(num);
+		for (auto _ : state) {
+			f.scaler.scale(f.patterns.inputRows(), 0, num);
+			benchmark::ClobberMemory();
+			state.PauseTiming();
+			f.patterns.restore();
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*(2*sizeof(double) + sizeof(double*)));
+	}
+	template<class S>
+	void BM_UpdateContiguous(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, 1);
+		for (auto _ : state) {
+			f.scaler.updateScalingFactors(&f.data[0], 1, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*sizeof(double));
+	}
+	template<class S>
+	void BM_UpdateStrided(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, stride);
+		for (auto _ : state) {
+			f.scaler.updateScalingFactors(&f.data[0], stride, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*sizeof(double));
+	}
+	template<class S>
+	void BM_UpdateRows(benchmark::State& state) {
+		const size_t num = state.range(0);
+		RowFixture<S> f(num);
+		for (auto _ : state) {
+			f.scaler.updateScalingFactors(f.patterns.inputRows(), 0, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*(sizeof(double) + sizeof(double*)));
+	}
+	template<class S>
+	void BM_ResetContiguous(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, 1);
+		for (auto _ : state) {
+			f.scaler.resetScalingFactors(&f.data[0], 1, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*sizeof(double));
+	}
+	template<class S>
+	void BM_ResetContiguousSkipping(benchmark::State& state) {
+		const size_t num = state.range(0);
+		MissingFixture<S> f(num);
+		for (auto _ : state) {
+			f.scaler.resetScalingFactors(&f.data[0], 1, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*sizeof(double));
+	}
+	template<class S>
+	void BM_ResetStrided(benchmark::State& state) {
+		const size_t num = state.range(0);
+		StridedFixture<S> f(num, stride);
+		for (auto _ : state) {
+			f.scaler.resetScalingFactors(&f.data[0], stride, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*sizeof(double));
+	}
+	template<class S>
+	void BM_ResetRows(benchmark::State& state) {
+		const size_t num = state.range(0);
+		RowFixture<S> f(num);
+		for (auto _ : state) {
+			f.scaler.resetScalingFactors(f.patterns.inputRows(), 0, num);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations()*num);
+		state.SetBytesProcessed(state.iterations()*num*(sizeof(double) + sizeof(double*)));
+	}
+}
+
+#define PULSE_SCALER_BENCHMARKS(S) \
+	BENCHMARK_TEMPLATE(BM_ScaleContiguous, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ScaleStrided, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ScaleRows, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_UpdateContiguous, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_UpdateStrided, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_UpdateRows, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ResetContiguous, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ResetStrided, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ResetRows, S)->RangeMultiplier(16)->Range(1<<8, 1<<20)
+
+PULSE_SCALER_BENCHMARKS(Normalize);
+PULSE_SCALER_BENCHMARKS(NormalizeWithFixpoint);
+PULSE_SCALER_BENCHMARKS(ScalerChain);
+
+#define PULSE_MISSING_VALUE_BENCHMARKS(S) \
+	BENCHMARK_TEMPLATE(BM_ScaleContiguousImputing, S)->RangeMultiplier(16)->Range(1<<8, 1<<20); \
+	BENCHMARK_TEMPLATE(BM_ResetContiguousSkipping, S)->RangeMultiplier(16)->Range(1<<8, 1<<20)
+
+PULSE_MISSING_VALUE_BENCHMARKS(Normalize);
+PULSE_MISSING_VALUE_BENCHMARKS(NormalizeWithFixpoint);
@@ -0,0 +1,189 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+/* pulse_seqlock_stress - torn reads of the concurrent mode of Normalize and NormalizeWithFixpoint.
+ *
+ * One writer thread keeps refitting a scaler in the concurrent mode (see
+ * Scaler::setConcurrent) to the range [-k, 2k] with a growing k, while reader
+ * threads check every parameter set they see: getParameters() has to return
+ * max == -2*min and one batch scale call has to use one range for all of its
+ * values. A torn min/max pair breaks either check.
+ *
+ * usage: pulse_seqlock_stress [--reads=N] [--readers=N]
+ *
+ * Returns 1 if a reader saw a torn parameter set.
+ */
+
+#include <pulse/Normalize.h>
+#include <pulse/NormalizeWithFixpoint.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using namespace pulse;
+	
+	struct Result {
+		std::string scaler;
+		size_t numReaders;
+		unsigned long reads;
+		unsigned long writes;
+		unsigned long torn;
+	};
+	
+	/** Returns true if the scaled values of in, which were scaled by one call, belong to a range [-k, 2k] */
+	typedef bool (*BatchCheck)(const double* out);
+	
+	/** Normalize to [0,1]: 0 is scaled to k/3k */
+	bool checkNormalize(const double* out) {
+		return fabs(out[0] - 1.0/3.0) < 1e-12;
+	}
+	/** NormalizeWithFixpoint with fixpoint 0 scaled to 0.5 in [0,1]: -1 is scaled to 0.5-0.5/k and 2 to 0.5+0.5/k */
+	bool checkNormalizeWithFixpoint(const double* out) {
+		return fabs(out[0] + out[1] - 1.0) < 1e-12;
+	}
+	
+	/** Runs the writer against numReaders readers, every reader checks reads parameter sets */
+	Result run(const std::string& name, Scaler& scaler, const double* in, size_t numIn, BatchCheck check, size_t numReaders, unsigned long reads) {
+		const bool concurrent = scaler.setConcurrent(true);
+		if (!concurrent) {
+			std::cerr<<name<<" does not support the concurrent mode"<<std::endl;
+			exit(1);
+		}
+		double extrema[2] = {-1.0, 2.0};
+		scaler.resetScalingFactors(extrema, 1, 2);
+		
+		std::atomic<size_t> numRunning(numReaders);
+		std::atomic<unsigned long> torn(0);
+		unsigned long writes = 0;
+		std::vector<std::thread> readers;
+		for (size_t r = 0; r < numReaders; r++) {
+			readers.push_back(std::thread([&]() {
+				std::vector<double> params;
+				params.reserve(8);
+				double out[2];
+				unsigned long numTorn = 0;
+				for (unsigned long i = 0; i < reads; i++) {
+					params.clear();
+					scaler.getParameters(params);
+					if (params[1] != -2.0*params[0]) {
+						numTorn++;
+					}
+					scaler.scale(in, 1, out, 1, numIn);
+					if (!check(out)) {
+						numTorn++;
+					}
+				}
+				torn.fetch_add(numTorn);
+				numRunning.fetch_sub(1);
+			}));
+		}
+		//the range only grows, every 2^20 steps it starts again with a reset
+		double k = 1.0;
+		while (numRunning.load() > 0) {
+			k = (k >= 1048576.0) ? 1.0 : k + 1.0;
+			extrema[0] = -k;
+			extrema[1] = 2.0*k;
+			if (k == 1.0) {
+				scaler.resetScalingFactors(extrema, 1, 2);
+			} else {
+				scaler.updateScalingFactors(extrema, 1, 2);
+			}
+			writes++;
+		}
+		for (size_t r = 0; r < numReaders; r++) {
+			readers[r].join();
+		}
+		
+		Result re;
+		re.scaler = name;
+		re.numReaders = numReaders;
+		re.reads = reads*numReaders;
+		re.writes = writes;
+		re.torn = torn.load();
+		return re;
+	}
+	
+	void print(const Result& r) {
+		printf("%-24s %7lu %12lu %12lu %8lu\n", r.scaler.c_str(), (unsigned long)r.numReaders, r.reads, r.writes, r.torn);
+	}
+}
+
+int main(int argc, char** argv) {
+	unsigned long reads = 1000000;
+	size_t numReaders = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--reads=", 8) == 0) {
+			reads = atol(argv[i]+8);
+		} else if (strncmp(argv[i], "--readers=", 10) == 0) {
+			numReaders = atol(argv[i]+10);
+		} else {
+			std::cerr<<"usage: "<<argv[0]<<" [--reads=N] [--readers=N]"<<std::endl;
+			return 1;
+		}
+	}
+	if (reads == 0 || numReaders == 0) {
+		std::cerr<<argv[0]<<": reads and readers have to be > 0"<<std::endl;
+		return 1;
+	}
+	
+	std::vector<Result> results;
+	{
+		Normalize scaler(0.0, 1.0);
+		const double in[1] = {0.0};
+		results.push_back(run("Normalize", scaler, in, 1, checkNormalize, numReaders, reads));
+	}
+	{
+		NormalizeWithFixpoint scaler(0.0, 0.5, 0.0, 1.0);
+		const double in[2] = {-1.0, 2.0};
+		results.push_back(run("NormalizeWithFixpoint", scaler, in, 2, checkNormalizeWithFixpoint, numReaders, reads));
+	}
+	
+	printf("%-24s %7s %12s %12s %8s\n", "scaler", "readers", "reads", "writes", "torn");
+	bool failed = false;
+	std::vector<Result>::const_iterator it;
+	for (it = results.begin(); it != results.end(); it++) {
+		print(*it);
+		failed |= (it->torn > 0);
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <vector>
+#include <cstddef>
+#include <atomic>
+
+namespace pulse {
+	/**
+	 * \brief The class ConcurrentRangeAccumulator collects the minimum and the maximum of several dimensions from many threads without locks.
+	 * Every thread updates one of numShards shards. A shard holds a relaxed atomic minimum and maximum per dimension and the shards are padded to separate cache lines, so threads with different shards do not share lines.
+	 * An update compares the value with the current extrema and only stores it with a compare and swap if it extends the range. Once the range is known most updates are loads, so even threads sharing a shard scale with the number of threads.
+	 * getExtrema() folds the shards. The extrema only grow, so a fold that happens concurrently with updates returns a valid range that is at least the range of all updates that finished before it.
+	 * PatternScaler::updateInputScalers(const ConcurrentRangeAccumulator&) applies the collected extrema to the scalers that can be fitted from extrema (Scaler::isExtremaSufficient()).
+	 */
+	class ConcurrentRangeAccumulator {
+	public:
+		/** Constructor
+		 *  \pre numDimensions > 0
+		 *  \pre numShards > 0
+		 *  \param numDimensions number of dimensions
+		 *  \param numShards number of shards, usually the number of updating threads
+		 */
+		ConcurrentRangeAccumulator(size_t numDimensions, size_t numShards);
+		
+		/** Extends the range of a dimension by value, NaNs are ignored. Can be called concurrently.
+		 *  \pre shard < numShards()
+		 *  \pre dimension < numDimensions()
+		 */
+		void update(size_t shard, size_t dimension, double value);
+		/** Extends the ranges of the dimensions start...start+num-1 by values[0...num-1], the counterpart of PatternScaler::updateInputScalers(const std::vector<double>&, size_t). Can be called concurrently.
+		 *  \pre shard < numShards()
+		 *  \pre start + num <= numDimensions()
+		 */
+		void update(size_t shard, const double* values, size_t start, size_t num);
+		/** Extends the ranges of the dimensions start...start+values.size()-1 by values using the shard of the calling thread, see getThreadShard(). Can be called concurrently.
+		 *  \pre start + values.size() <= numDimensions()
+		 */
+		void update(const std::vector<double>& values, size_t start);
+		/** Returns the extrema of a dimension over all shards, min > max if the dimension has not been updated. Can be called concurrently with updates.
+		 *  \pre dimension < numDimensions()
+		 */
+		void getExtrema(size_t dimension, double& min, double& max) const;
+		/** Forgets all values
+		 *  \note must not be called concurrently with updates
+		 */
+		void clear();
+		/** Returns the shard of the calling thread: the threads are numbered in the order of their first call and the number is taken modulo numShards() */
+		size_t getThreadShard() const;
+		
+		size_t numDimensions() const;
+		size_t numShards() const;
+	private:
+		ConcurrentRangeAccumulator(const ConcurrentRangeAccumulator&);
+		ConcurrentRangeAccumulator& operator=(const ConcurrentRangeAccumulator&);
+		
+		size_t m_numDimensions;
+		size_t m_numShards;
+		/** Distance between two shards in values, the minima and maxima of a shard followed by at least one cache line of padding */
+		size_t m_stride;
+		std::vector<std::atomic<double> > m_extrema;
+	};
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+
+namespace pulse {
+	/**
+	 * \brief The class ExponentialDecayNormalize linearly scales [mean - numDeviations*deviation, mean + numDeviations*deviation] to [m_minNorm, m_maxNorm], where mean and deviation are exponentially weighted over all values passed to the update methods.
+	 * The weight of a value halves every halfLife values, so the scaling continuously adapts to recent data. The state is O(1): the total weight, the weighted mean and the weighted variance.
+	 * Updating with a block of values uses the closed form of the decay over the block instead of a dependent per value update, so the block is summed in independent lanes that can be vectorized.
+	 * NaN values are skipped by all update methods, they neither contribute nor decay the other values.
+	 */
+	class ExponentialDecayNormalize : public Scaler {
+	public:
+		/** Constructor
+		 *  \note the range is [-1,1] until the first update or reset
+		 *  \pre minNorm < maxNorm
+		 *  \pre halfLife > 0
+		 *  \pre numDeviations > 0
+		 *  \param minNorm the scaled value of mean - numDeviations*deviation
+		 *  \param maxNorm the scaled value of mean + numDeviations*deviation
+		 *  \param halfLife number of values after which the weight of a value has halved
+		 *  \param numDeviations number of standard deviations between the mean and the boundries
+		 */
+		ExponentialDecayNormalize(double minNorm, double maxNorm, double halfLife, double numDeviations);
+		virtual ~ExponentialDecayNormalize() {}
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double value);
+		/** Adds num copies of value with the closed form of their decayed weights */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		/** The parameters are mean, variance, weight, minNorm, maxNorm, halfLife and numDeviations */
+		virtual void getParameters(std::vector<double>& params) const;
+		virtual void setParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** Combines the moments weighted by their weights, both are treated as streams of the same time span
+		 *  \throw MergeException if other is no ExponentialDecayNormalize or has another norm range, half-life or number of deviations
+		 */
+		virtual void merge(const Scaler& other);
+		/** Returns the exponentially weighted mean */
+		double getMean() const;
+		/** Returns the exponentially weighted variance */
+		double getVariance() const;
+	private:
+		/** Adds a block with the decayed sums B1 = sum a^(n-1-i)*(x_i-center) and B2 = sum a^(n-1-i)*(x_i-center)^2 */
+		void addBlock(size_t num, double center, double sum, double sumOfSquares);
+		/** Updates m_slope and m_lower */
+		void updateCoefficients();
+		/** Updates with the values of data that are not NaN */
+		template<class Accessor>
+		void update(const Accessor& data, size_t num);
+		/** Updates with num values in the closed form
+		 *  \pre none of the values is NaN
+		 */
+		template<class Accessor>
+		void updateBlock(const Accessor& data, size_t num);
+		
+		double m_mean;
+		double m_variance;
+		double m_weight;
+		double m_minNorm;
+		double m_maxNorm;
+		double m_halfLife;
+		double m_numDeviations;
+		/** per value decay factor 2^(-1/halfLife) */
+		double m_decay;
+		/** mean - numDeviations*deviation */
+		double m_lower;
+		/** (maxNorm-minNorm)/(2*numDeviations*deviation) */
+		double m_slope;
+		static std::string m_name;
+	};
+}
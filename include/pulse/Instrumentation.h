@@ -0,0 +1,150 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <pulse/FileOpenException.h>
+
+namespace pulse {
+	/** Values of all instrumentation counters at one point in time */
+	struct InstrumentationSnapshot {
+		/** values scaled by PatternScaler */
+		unsigned long valuesScaled;
+		/** values used to update or reset the scalers of a PatternScaler */
+		unsigned long valuesFitted;
+		/** values returned to their original values by PatternScaler::originalTargetValues */
+		unsigned long valuesRestored;
+		/** bytes read by CSVReader */
+		unsigned long bytesParsed;
+		/** files loaded by PatternScaler::loadFromFile */
+		unsigned long filesLoaded;
+		/** files written by PatternScaler::saveToFile */
+		unsigned long filesSaved;
+		/** cumulative nanoseconds per operation (parsing by ScalerFactory is also part of loading) */
+		unsigned long scaleNanoseconds;
+		unsigned long fitNanoseconds;
+		unsigned long restoreNanoseconds;
+		unsigned long parseNanoseconds;
+		unsigned long loadNanoseconds;
+		unsigned long saveNanoseconds;
+	};
+	
+	/** Process wide counters and timers of the hot paths of PatternScaler, ScalerFactory and CSVReader.
+	 *  The instrumentation is only compiled in if PULSE_INSTRUMENTATION is defined, otherwise the PULSE_COUNT and PULSE_TIME macros expand to nothing.
+	 *  If it is compiled in, it still has to be enabled with setEnabled(true); while disabled every instrumented call costs a single relaxed load.
+	 *  All counters are relaxed atomics, so they can be updated from several threads.
+	 */
+	class Instrumentation {
+	public:
+		enum Counter {
+			ValuesScaled,
+			ValuesFitted,
+			ValuesRestored,
+			BytesParsed,
+			FilesLoaded,
+			FilesSaved,
+			NumCounters
+		};
+		enum Timer {
+			ScaleTime,
+			FitTime,
+			RestoreTime,
+			ParseTime,
+			LoadTime,
+			SaveTime,
+			NumTimers
+		};
+		
+		/** Enables or disables the counting at runtime (disabled by default) */
+		static void setEnabled(bool enabled);
+		/** True if the counting is enabled */
+		static inline bool isEnabled() {
+			return s_enabled.load(std::memory_order_relaxed);
+		}
+		/** Adds n to a counter */
+		static void count(Counter counter, unsigned long n);
+		/** Adds nanoseconds to a timer */
+		static void addTime(Timer timer, unsigned long nanoseconds);
+		/** Returns the current monotonic time in nanoseconds */
+		static unsigned long now();
+		/** Sets all counters and timers to 0 */
+		static void reset();
+		/** Returns the current values of all counters and timers */
+		static InstrumentationSnapshot snapshot();
+		/** Writes all counters and timers in the Prometheus text exposition format */
+		static void writePrometheus(std::ostream& out);
+		/** Writes all counters and timers in the Prometheus text exposition format into a file.
+		 *  The file is written under a temporary name and then renamed, so a collector never reads a half written file.
+		 *  \param filename
+		 */
+		static void writePrometheus(const std::string& filename) throw (FileOpenException);
+	private:
+		Instrumentation();
+		
+		static std::atomic<bool> s_enabled;
+	};
+	
+	/** Adds the time between construction and destruction to a timer, if the instrumentation was enabled at construction */
+	class ScopedInstrumentationTimer {
+	public:
+		explicit ScopedInstrumentationTimer(Instrumentation::Timer timer) :
+			m_timer(timer),
+			m_start(Instrumentation::isEnabled() ? Instrumentation::now() : 0)
+		{}
+		~ScopedInstrumentationTimer() {
+			if (m_start != 0) {
+				Instrumentation::addTime(m_timer, Instrumentation::now() - m_start);
+			}
+		}
+	private:
+		ScopedInstrumentationTimer(const ScopedInstrumentationTimer&);
+		ScopedInstrumentationTimer& operator=(const ScopedInstrumentationTimer&);
+		
+		Instrumentation::Timer m_timer;
+		unsigned long m_start;
+	};
+}
+
+#ifdef PULSE_INSTRUMENTATION
+/** Adds n to the counter pulse::Instrumentation::counter, n is only evaluated if the instrumentation is enabled */
+#define PULSE_COUNT(counter, n) do { if (pulse::Instrumentation::isEnabled()) { pulse::Instrumentation::count(pulse::Instrumentation::counter, (n)); } } while (false)
+/** Adds the time until the end of the current scope to the timer pulse::Instrumentation::timer */
+#define PULSE_TIME(timer) pulse::ScopedInstrumentationTimer pulseInstrumentationTimer(pulse::Instrumentation::timer)
+#else
+#define PULSE_COUNT(counter, n) do {} while (false)
+#define PULSE_TIME(timer) do {} while (false)
+#endif
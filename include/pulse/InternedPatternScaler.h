@@ -0,0 +1,118 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <pulse/PatternScaler.h>
+#include <pulse/ScalingTable.h>
+
+namespace pulse {
+	/**
+	 * \brief The class InternedPatternScaler is a read only copy of the scaling of a PatternScaler that stores the parameters of every dimension as an index into a ScalingTable.
+	 * Every dimension needs 4 bytes plus the distinct functions of the table, instead of a scaler per dimension. Consecutive dimensions with the same function are grouped into runs that are scaled by one broadcast loop over the values, the other dimensions look their function up in the table.
+	 * Dimensions whose scaler is not a PiecewiseLinear function keep a copy of the scaler.
+	 * The inputs are imputed like by the PatternScaler, if its policy is ImputeMissing (see PatternScaler::setMissingValuePolicy()).
+	 * The InternedPatternScaler has to be constructed again after the PatternScaler was updated.
+	 */
+	class InternedPatternScaler {
+	public:
+		/** Constructor
+		 *  \param patternScaler the fitted PatternScaler
+		 *  \param table the table the functions are interned in, it can be shared with other InternedPatternScalers and has to outlive this one
+		 *  \param minRunLength the minimal number of consecutive dimensions with the same function that are scaled by a broadcast loop
+		 */
+		InternedPatternScaler(const PatternScaler& patternScaler, ScalingTable& table, size_t minRunLength = 8);
+		~InternedPatternScaler();
+		
+		/** Scales the values with the input scaling, see PatternScaler::scaleInput()
+		 *  \param values numInputDimensions() unscaled values
+		 */
+		void scaleInput(double* values) const;
+		/** Scales the input values of a PatternSet, see PatternScaler::scaleInputs()
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 */
+		void scaleInputs(NPP2::PatternSet& patternSet) const;
+		/** Takes scaled target values and returns them to their original not scaled values, see PatternScaler::originalTargetValues()
+		 *  \param values numTargetDimensions() scaled values
+		 */
+		void originalTargetValues(double* values) const;
+		
+		size_t numInputDimensions() const;
+		size_t numTargetDimensions() const;
+		/** Returns the index of the function of an input dimension in the table, or noFunction if its scaler is not a PiecewiseLinear function
+		 *  \pre dimension < numInputDimensions()
+		 */
+		uint32_t getInputIndex(size_t dimension) const;
+		/** Returns the number of runs of input dimensions that are scaled by a broadcast loop */
+		size_t numInputBroadcasts() const;
+		
+		static const uint32_t noFunction = 0xffffffff;
+	private:
+		InternedPatternScaler(const InternedPatternScaler&);
+		InternedPatternScaler& operator=(const InternedPatternScaler&);
+		
+		/** The dimensions [begin, end), broadcast if they all use the function of begin */
+		struct Run {
+			size_t begin;
+			size_t end;
+			bool broadcast;
+		};
+		/** The interned scaling of the inputs or of the targets */
+		struct Dimensions {
+			std::vector<uint32_t> index;
+			std::vector<Run> runs;
+			/** The dimensions without a PiecewiseLinear function and copies of their scalers */
+			std::vector<size_t> fallback;
+			std::vector<Scaler*> fallbackScalers;
+		};
+		/** Interns the function of scaler (or its inverse) for the next dimension */
+		static void addDimension(Dimensions& dimensions, const Scaler& scaler, ScalingTable& table, bool inverse);
+		/** Groups the dimensions into runs */
+		void buildRuns(Dimensions& dimensions) const;
+		void apply(const Dimensions& dimensions, double* values, bool inverse) const;
+		
+		const ScalingTable& m_table;
+		size_t m_minRunLength;
+		/** True if missing input values are replaced by m_imputedValue */
+		bool m_impute;
+		double m_imputedValue;
+		Dimensions m_inputs;
+		Dimensions m_targets;
+	};
+}
@@ -38,6 +38,7 @@
  */
 
 #include <pulse/Scaler.h>
+#include <pulse/SeqLock.h>
 
 namespace pulse {
 	/**
@@ -89,17 +90,46 @@ namespace pulse {
 		virtual void scale(double** data, size_t offset, size_t num) const;
 		virtual double scale(double value) const;
 		virtual double originalValue(double value) const;
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		virtual bool isExtremaSufficient() const;
 		virtual void getParameters(std::vector<double>& params) const;
 		virtual void setParameters(const std::vector<double>& params);
 		virtual const std::string& getTypeName() const;
 		virtual Scaler* clone() const;
+		/** \throw MergeException if other is no NormalizeWithFixpoint or has another norm range or fixpoint */
+		virtual void merge(const Scaler& other);
+		virtual bool setConcurrent(bool concurrent);
+		virtual bool setMissingValuePolicy(MissingValuePolicy policy, double imputedValue = 0.0);
+		virtual MissingValuePolicy getMissingValuePolicy(double& imputedValue) const;
+		virtual size_t getMissingCount() const;
 	private:
+		/** The parameters the const methods work with */
+		struct State {
+			double min;
+			double max;
+			double fixpoint;
+			double fixpointNorm;
+			double minNorm;
+			double maxNorm;
+		};
+		/** Returns the parameters, in the concurrent mode the last published ones */
+		State getState() const;
+		/** Publishes the parameters in the concurrent mode, called after every change */
+		void publish();
+		double scale(double value, const State& state) const;
+		
 		double m_min;
 		double m_max;
 		double m_fixpoint;
 		double m_fixpointNorm;
 		double m_minNorm;
 		double m_maxNorm;
+		bool m_concurrent;
+		MissingValuePolicy m_missingPolicy;
+		double m_imputedValue;
+		size_t m_missingCount;
+		SeqLock<State> m_published;
 		static std::string m_name;
 	};
 }
\ No newline at end of file
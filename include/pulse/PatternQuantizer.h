@@ -0,0 +1,129 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <pulse/PatternScaler.h>
+
+namespace pulse {
+	/**
+	 * \brief The class PatternQuantizer scales the inputs of patterns directly to signed 8 or 16 bit integers, e.g. for networks with quantized inputs.
+	 * The quantization of every dimension is derived from the norm range of its scaler (Scaler::getNormRange()): the range is mapped onto all values of the integer type, a scaled value y is stored as q = round(y/scale) + zeroPoint and saturated to the integer range.
+	 * Scaling, rounding and saturation are fused into one pass over the pattern for the dimensions that can be described as PiecewiseLinear functions, so no scaled doubles are written out. The other dimensions are scaled with their scalers first.
+	 * The division by the scale is folded into the scaling functions, so values within a rounding error of a tie can differ by one from quantizing the result of PatternScaler::scaleInput().
+	 * Missing values are quantized to the imputed value, if the policy of the PatternScaler is ImputeMissing (see PatternScaler::setMissingValuePolicy()).
+	 * The quantizer copies the parameters of the scalers, it has to be constructed again after the PatternScaler was updated.
+	 */
+	class PatternQuantizer {
+	public:
+		/** The quantization of one dimension: a quantized value q stands for the scaled value (q - zeroPoint)*scale */
+		struct Quantization {
+			double scale;
+			int zeroPoint;
+		};
+		
+		/** Constructor
+		 *  \pre bits == 8 || bits == 16
+		 *  \pre all input scalers of patternScaler have a norm range (Scaler::getNormRange())
+		 *  \param patternScaler the fitted PatternScaler
+		 *  \param bits the width of the quantized values
+		 */
+		PatternQuantizer(const PatternScaler& patternScaler, unsigned int bits);
+		~PatternQuantizer();
+		
+		/** Scales and quantizes the values of one pattern
+		 *  \pre getBits() == 8
+		 *  \pre the values are not NaN, unless the policy of the PatternScaler is ImputeMissing
+		 *  \param values numInputDimensions() not scaled values
+		 *  \param out space for numInputDimensions() quantized values
+		 */
+		void quantizeInput(double const* values, int8_t* out) const;
+		/** Scales and quantizes the values of one pattern
+		 *  \pre getBits() == 16
+		 *  \pre the values are not NaN, unless the policy of the PatternScaler is ImputeMissing
+		 *  \param values numInputDimensions() not scaled values
+		 *  \param out space for numInputDimensions() quantized values
+		 */
+		void quantizeInput(double const* values, int16_t* out) const;
+		/** Scales and quantizes the inputs of a PatternSet into patterns stored row by row, the PatternSet is not changed.
+		 *  \pre getBits() == 8
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \param patternSet an PatternSet with not scaled input values
+		 *  \param out space for patternSet.pattern_count*numInputDimensions() quantized values
+		 */
+		void quantizeInputs(const NPP2::PatternSet& patternSet, int8_t* out) const;
+		/** Scales and quantizes the inputs of a PatternSet into patterns stored row by row, the PatternSet is not changed.
+		 *  \pre getBits() == 16
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \param patternSet an PatternSet with not scaled input values
+		 *  \param out space for patternSet.pattern_count*numInputDimensions() quantized values
+		 */
+		void quantizeInputs(const NPP2::PatternSet& patternSet, int16_t* out) const;
+		
+		/** Returns the quantization of an input dimension
+		 *  \pre dimension < numInputDimensions()
+		 */
+		const Quantization& getQuantization(size_t dimension) const;
+		unsigned int getBits() const;
+		size_t numInputDimensions() const;
+	private:
+		PatternQuantizer(const PatternQuantizer&);
+		PatternQuantizer& operator=(const PatternQuantizer&);
+		
+		template<class T>
+		void quantize(double const* values, T* out) const;
+		
+		unsigned int m_bits;
+		/** The smallest quantized value */
+		int m_minValue;
+		/** The number of quantized values - 1 */
+		double m_span;
+		std::vector<Quantization> m_quantization;
+		/** The scaling functions in units of the quantization, shifted by 0.5 - m_minValue so truncating the saturated result rounds it */
+		std::vector<double> m_pivot;
+		std::vector<double> m_pivotValue;
+		std::vector<double> m_slopeBelow;
+		std::vector<double> m_slopeAbove;
+		/** The imputed value in the same units, empty if the policy is not ImputeMissing */
+		std::vector<double> m_imputed;
+		/** The dimensions without a PiecewiseLinear function and clones of their scalers */
+		std::vector<size_t> m_fallback;
+		std::vector<Scaler*> m_fallbackScalers;
+	};
+}
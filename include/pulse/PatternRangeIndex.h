@@ -0,0 +1,118 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <vector>
+#include <cstddef>
+#include <npp2.h>
+#include <PatternSet.h>
+
+namespace pulse {
+	/**
+	 * \brief The class PatternRangeIndex answers minimum and maximum queries of the dimensions of a NPP2::PatternSet over arbitrary pattern ranges without scanning them.
+	 * The values are copied column by column and split into blocks of blockSize patterns. A sparse table over the block extrema answers queries over whole blocks in O(1), only the at most 2*blockSize values of the partial blocks at the ends of a range are scanned.
+	 * This makes refitting on many overlapping subsets of one PatternSet (cross validation folds, backtest windows) cheap, see PatternScaler::resetScalers(const PatternRangeIndex&, const std::vector<PatternRangeIndex::Range>&).
+	 * The index needs the memory of the PatternSet plus about 2*log2(numPatterns/blockSize)/blockSize of it for the table. It is not updated if the PatternSet changes.
+	 */
+	class PatternRangeIndex {
+	public:
+		/** A half open range [begin, end) of pattern indices */
+		struct Range {
+			Range(size_t begin, size_t end);
+			size_t begin;
+			size_t end;
+		};
+		
+		/** Constructor - builds the index over all patterns of patternSet
+		 *  \pre blockSize > 0
+		 *  \param patternSet an PatternSet with not scaled values
+		 *  \param blockSize number of patterns per block
+		 */
+		explicit PatternRangeIndex(const NPP2::PatternSet& patternSet, size_t blockSize = 32);
+		
+		/** Returns the minimum and the maximum of an input dimension over the patterns in range
+		 *  \pre dimension < numInputDimensions()
+		 *  \pre range.begin < range.end <= numPatterns()
+		 */
+		void getInputExtrema(size_t dimension, const Range& range, double& min, double& max) const;
+		/** Returns the minimum and the maximum of an input dimension over the union of ranges
+		 *  \pre dimension < numInputDimensions()
+		 *  \pre at least one range is not empty
+		 */
+		void getInputExtrema(size_t dimension, const std::vector<Range>& ranges, double& min, double& max) const;
+		/** Returns the minimum and the maximum of a target dimension over the patterns in range
+		 *  \pre dimension < numTargetDimensions()
+		 *  \pre range.begin < range.end <= numPatterns()
+		 */
+		void getTargetExtrema(size_t dimension, const Range& range, double& min, double& max) const;
+		/** Returns the minimum and the maximum of a target dimension over the union of ranges
+		 *  \pre dimension < numTargetDimensions()
+		 *  \pre at least one range is not empty
+		 */
+		void getTargetExtrema(size_t dimension, const std::vector<Range>& ranges, double& min, double& max) const;
+		/** Returns the values of an input dimension of all patterns as contiguous array */
+		const double* getInputColumn(size_t dimension) const;
+		/** Returns the values of a target dimension of all patterns as contiguous array */
+		const double* getTargetColumn(size_t dimension) const;
+		
+		size_t numPatterns() const;
+		size_t numInputDimensions() const;
+		size_t numTargetDimensions() const;
+		
+		/** Returns the ranges of the training patterns of fold of a k-fold cross validation with contiguous folds: all patterns except [fold*numPatterns/numFolds, (fold+1)*numPatterns/numFolds)
+		 *  \pre fold < numFolds
+		 */
+		static std::vector<Range> getTrainingRanges(size_t numPatterns, size_t numFolds, size_t fold);
+	private:
+		/** The values of one dimension and the sparse table of its block extrema */
+		struct Column {
+			std::vector<double> values;
+			/** level l contains the extrema of 2^l blocks starting at each block, the levels are stored one after another */
+			std::vector<double> min;
+			std::vector<double> max;
+		};
+		void build(Column& column) const;
+		void getExtrema(const Column& column, const Range& range, double& min, double& max) const;
+		
+		size_t m_numPatterns;
+		size_t m_blockSize;
+		size_t m_numBlocks;
+		/** Offset of every level of the sparse tables */
+		std::vector<size_t> m_levelOffsets;
+		std::vector<Column> m_inputs;
+		std::vector<Column> m_targets;
+	};
+}
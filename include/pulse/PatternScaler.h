@@ -41,6 +41,8 @@
 #include <string>
 #include <vector>
 #include <pulse/Scaler.h>
+#include <pulse/PatternRangeIndex.h>
+#include <pulse/ConcurrentRangeAccumulator.h>
 #include <npp2.h>
 #include <PatternSet.h>
 #include <pulse/FileOpenException.h>
@@ -122,12 +124,34 @@ namespace pulse {
 		 *  \param patternSet an PatternSet with not scaled values
 		 */
 		void updateScalers(const NPP2::PatternSet& patternSet);
+		/** Updates the input and target scalers with the patterns of patternSet starting at firstPattern. This allows to fit a PatternSet that grows by appending patterns incrementally: only the appended patterns are scanned.
+		 *  \code
+		 *  size_t seen = 0;
+		 *  ...
+		 *  seen = patternScaler.updateScalers(patternSet, seen); //after every append
+		 *  \endcode
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \pre patternSet.target_count == numTargetDimensions()
+		 *  \pre firstPattern <= patternSet.pattern_count
+		 *  \param patternSet an PatternSet with not scaled values
+		 *  \param firstPattern index of the first pattern that has not been seen yet
+		 *  \return patternSet.pattern_count, the firstPattern of the next call
+		 */
+		size_t updateScalers(const NPP2::PatternSet& patternSet, size_t firstPattern);
 		/** Updates the input scalers with the input data in the patternSet
 		 *  \pre patternSet.input_count == numInputDimensions()
 		 *  \pre patternSet.pattern_count > 0
 		 *  \param patternSet an PatternSet with not scaled input values
 		 */
 		void updateInputScalers(const NPP2::PatternSet& patternSet);
+		/** Updates the input scalers with the input data of the patterns of patternSet starting at firstPattern
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \pre firstPattern <= patternSet.pattern_count
+		 *  \param patternSet an PatternSet with not scaled input values
+		 *  \param firstPattern index of the first pattern that has not been seen yet
+		 *  \return patternSet.pattern_count, the firstPattern of the next call
+		 */
+		size_t updateInputScalers(const NPP2::PatternSet& patternSet, size_t firstPattern);
 		/** Updates the input scalers with the given data
 		 *  \pre num > 0
 		 *  \param in the pointer to the data, this is beeing accesed data[i][j] with \f$i \in {0...num-1}\f$ and \f$j \in {0...numInputDimensions()}\f$
@@ -135,16 +159,33 @@ namespace pulse {
 		 */
 		void updateInputScalers(double** in, size_t num);
 		/** Updates the input scalers with the value in the vector.
+		 *  The values are first compared with the ranges this method has already passed to the scalers that can be fitted from extrema (Scaler::isExtremaSufficient()), only values outside of them are passed to their scalers. Once the ranges are known most samples are handled by one vectorized pass without virtual calls.
 		 *  \pre values.size() + start <= m_inputScalers.size()
 		 *  \param values unscaled values
 		 *  \param start the position in the vector where the values is that the first scaled should use to update itself
 		 */
 		void updateInputScalers(const std::vector<double>& values, size_t start);
+		/** Updates the input scalers with the extrema collected by several threads in accumulator. Dimensions without values are skipped.
+		 *  The ingestion threads call ConcurrentRangeAccumulator::update() instead of updateInputScalers(const std::vector<double>&, size_t) without a lock, the thread that owns the PatternScaler calls this method before it scales. As the extrema only grow, applying the same accumulator again does not change the scalers.
+		 *  Scalers that can not be fitted from extrema (Scaler::isExtremaSufficient()) are not updated, their dimensions are returned so the caller can fit them from the values.
+		 *  \pre accumulator.numDimensions() == numInputDimensions()
+		 *  \param accumulator
+		 *  \return the ascending input dimensions whose scalers were skipped because they can not be fitted from extrema
+		 */
+		std::vector<size_t> updateInputScalers(const ConcurrentRangeAccumulator& accumulator);
 		/** Updates the target scalers with the given data
 		*  \pre patternSet.pattern_count > 0
 		*  \param patternSet an PatternSet with not scaled target values
 		*/
 		void updateTargetScalers(const NPP2::PatternSet& patternSet);
+		/** Updates the target scalers with the target data of the patterns of patternSet starting at firstPattern
+		 *  \pre patternSet.target_count == numTargetDimensions()
+		 *  \pre firstPattern <= patternSet.pattern_count
+		 *  \param patternSet an PatternSet with not scaled target values
+		 *  \param firstPattern index of the first pattern that has not been seen yet
+		 *  \return patternSet.pattern_count, the firstPattern of the next call
+		 */
+		size_t updateTargetScalers(const NPP2::PatternSet& patternSet, size_t firstPattern);
 		
 		/*@}*/
 #ifdef __APPLE__
@@ -173,6 +214,81 @@ namespace pulse {
 		 *  \param patternSet an PatternSet with not scaled target values
 		 */
 		void resetTargetScalers(const NPP2::PatternSet& patternSet);
+		/** Resets the input and target scalers with the patterns in the union of ranges, using an index built over the PatternSet once.
+		 *  Scalers that can be fitted from the extrema (Scaler::isExtremaSufficient(), e.g. Normalize) are fitted from the index without scanning the patterns, the other scalers scan the contiguous columns of the index.
+		 *  \code
+		 *  PatternRangeIndex index(patternSet);
+		 *  for (size_t fold = 0; fold < 10; fold++) {
+		 *  	patternScaler.resetScalers(index, PatternRangeIndex::getTrainingRanges(index.numPatterns(), 10, fold));
+		 *  	...
+		 *  }
+		 *  \endcode
+		 *  \pre index.numInputDimensions() == numInputDimensions()
+		 *  \pre index.numTargetDimensions() == numTargetDimensions()
+		 *  \pre at least one range is not empty, range.end <= index.numPatterns() for all ranges
+		 *  \param index the index of the PatternSet with not scaled values
+		 *  \param ranges the ranges of the patterns that are used
+		 */
+		void resetScalers(const PatternRangeIndex& index, const std::vector<PatternRangeIndex::Range>& ranges);
+		/** Resets the input and target scalers with the patterns in range, see resetScalers(const PatternRangeIndex&, const std::vector<PatternRangeIndex::Range>&)
+		 *  \pre range.begin < range.end <= index.numPatterns()
+		 *  \param index the index of the PatternSet with not scaled values
+		 *  \param range the range of the patterns that are used
+		 */
+		void resetScalers(const PatternRangeIndex& index, const PatternRangeIndex::Range& range);
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Merging of fitted scalers
+#endif
+		/** \name Merging of fitted scalers
+		 @{ */
+		
+		/** Merges the scalers of other into the scalers of this, see Scaler::merge(). This combines PatternScalers that were fitted on different shards of the data into the PatternScaler fitted on all of it.
+		 *  The scalers are merged into copies that replace them once all merges succeeded, so this is not changed if the exception is thrown.
+		 *  \throw MergeException if the dimensions differ or if two scalers of a dimension can not be merged (e.g. different types, norm ranges or configurations), the message names the dimension
+		 *  \param other
+		 */
+		void merge(const PatternScaler& other) throw (MergeException);
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Concurrent scaling
+#endif
+		/** \name Concurrent scaling
+		 @{ */
+		
+		/** Enables or disables the concurrent mode of all scalers, see Scaler::setConcurrent(). In the concurrent mode one thread can update the scalers while other threads scale, every scaler is read consistently.
+		 *  \note The scalers must not be added while other threads use the PatternScaler.
+		 *  \param concurrent
+		 *  \return false if at least one scaler does not support the concurrent mode
+		 */
+		bool setConcurrent(bool concurrent);
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Missing values
+#endif
+		/** \name Missing values
+		 @{ */
+		
+		/** Sets how all scalers treat NaN and infinite values, see Scaler::setMissingValuePolicy(). Scalers added afterwards get the policy as well and the single precision kernels impute in the same loop as they scale.
+		 *  \param policy
+		 *  \param imputedValue the scaled value missing values are replaced with by ImputeMissing
+		 *  \return false if at least one scaler does not support the policy
+		 */
+		bool setMissingValuePolicy(MissingValuePolicy policy, double imputedValue = 0.0);
+		/** Returns the policy set with setMissingValuePolicy(), the copies of the scaling (InternedPatternScaler, PatternQuantizer) impute with it
+		 *  \param imputedValue is set to the imputed value
+		 */
+		MissingValuePolicy getMissingValuePolicy(double& imputedValue) const;
+		/** Returns the number of missing values every input scaler skipped while fitting, see Scaler::getMissingCount() */
+		std::vector<size_t> getInputMissingCounts() const;
+		/** Returns the number of missing values every target scaler skipped while fitting, see Scaler::getMissingCount() */
+		std::vector<size_t> getTargetMissingCounts() const;
 		
 		/*@}*/
 #ifdef __APPLE__
@@ -215,6 +331,106 @@ namespace pulse {
 		/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Single precision scaling
+#endif
+		/** \name Single precision scaling
+		 @{ */
+		
+		/** Scales float values with the input scalers, see Scaler::scaleFloats().
+		 *  \param values unscaled float values
+		 */
+		void scaleInput(float* values) const;
+		/** Scales numPatterns float patterns stored row by row (pattern i starts at patterns + i*numInputDimensions()). The parameters are kept in double, the dimensions that can be described as PiecewiseLinear functions are scaled in float by a single pass over the patterns, which processes twice the values per vector register of the double version.
+		 *  \note Computing in float adds an error of a few ulp of the scaled value on top of the rounding of the input itself.
+		 *  \param patterns unscaled float patterns
+		 *  \param numPatterns
+		 */
+		void scaleInputs(float* patterns, size_t numPatterns) const;
+		/** Scales the input values of a PatternSet into float patterns stored row by row, the PatternSet is not changed. The scaling is computed in double, so every value is only rounded once.
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \param patternSet an PatternSet with not scaled input values
+		 *  \param out space for patternSet.pattern_count*numInputDimensions() floats
+		 */
+		void scaleInputs(const NPP2::PatternSet& patternSet, float* out) const;
+		/** Scales the target values of a PatternSet into float patterns stored row by row, the PatternSet is not changed.
+		 *  \pre patternSet.target_count == numTargetDimensions()
+		 *  \param patternSet an PatternSet with not scaled target values
+		 *  \param out space for patternSet.pattern_count*numTargetDimensions() floats
+		 */
+		void scaleTargets(const NPP2::PatternSet& patternSet, float* out) const;
+		/** Takes scaled float values (e.g. the outputs of a network) and returns them to their original not scaled values
+		 *  \param values scaled values
+		 */
+		void originalTargetValues(float* values) const;
+		/** Returns numPatterns scaled float patterns stored row by row to their original not scaled values
+		 *  \param patterns scaled patterns
+		 *  \param numPatterns
+		 */
+		void originalTargetValues(float* patterns, size_t numPatterns) const;
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Sparse input patterns
+#endif
+		/** \name Sparse input patterns
+		 *  Sparse patterns are stored in the CSR format: the non-zero values of pattern i are values[rowStart[i]] to values[rowStart[i+1]-1], their input dimensions are at the same positions in indices. All other values of a pattern are implicit zeros.
+		 @{ */
+		
+		/** Updates the input scalers with numPatterns sparse patterns. Every scaler sees the values of its dimension in row order, so order dependent scalers (e.g. SlidingWindowNormalize) are fitted like with the dense patterns.
+		 *  The implicit zeros are passed without materializing them: every run of zeros in front of a stored value (and behind the last one) is passed once to scalers that can be fitted from extrema (skipped if their seen range already contains 0, see updateInputScalers(const std::vector<double>&, size_t)) and with the closed form of Scaler::updateScalingFactorsRepeated() to the others.
+		 *  \pre every index < numInputDimensions() and no index appears twice in a pattern
+		 *  \param rowStart numPatterns+1 offsets into indices and values
+		 *  \param indices the input dimension of every value
+		 *  \param values unscaled non-zero values
+		 *  \param numPatterns
+		 */
+		void updateInputScalers(const size_t* rowStart, const size_t* indices, const double* values, size_t numPatterns);
+		/** Scales the stored values of numPatterns sparse patterns in place with the scalers of their dimensions, the implicit zeros scale to getScaledInputZeros(). If there are at least four values per dimension they are scaled by one pass that gathers the PiecewiseLinear functions of their dimensions, otherwise value by value by the scalers.
+		 *  \pre every index < numInputDimensions()
+		 *  \param rowStart numPatterns+1 offsets into indices and values
+		 *  \param indices the input dimension of every value
+		 *  \param values unscaled non-zero values
+		 *  \param numPatterns
+		 */
+		void scaleInputs(const size_t* rowStart, const size_t* indices, double* values, size_t numPatterns) const;
+		/** Returns the scaled value of 0 for every input dimension. Computed once after fitting it is the dense background a sparse pattern scaled by scaleInputs(const size_t*, const size_t*, double*, size_t) is scattered into. */
+		std::vector<double> getScaledInputZeros() const;
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Rescaling of scaled data
+#endif
+		/** \name Rescaling of scaled data
+		 @{ */
+		
+		/** Transforms a PatternSet that was scaled by previous into the PatternSet this PatternScaler would produce from the not scaled values, see Scaler::rescale(). The dimensions that can be described as PiecewiseLinear functions are rescaled by a single pass over the patterns, so the not scaled data does not have to be kept to follow updates of the scalers.
+		 *  \pre previous.numInputDimensions() == numInputDimensions()
+		 *  \pre previous.numTargetDimensions() == numTargetDimensions()
+		 *  \param previous the PatternScaler that scaled the PatternSet, usually a copy taken before an update
+		 *  \param patternSet an PatternSet scaled by previous
+		 */
+		void rescale(const PatternScaler& previous, NPP2::PatternSet& patternSet) const;
+		/** Rescales the first numScaled patterns that were scaled by previous and scales the remaining not scaled patterns. This brings a PatternSet that grows by appending to the scaling of this after an incremental update:
+		 *  \code
+		 *  PatternScaler previous(patternScaler);
+		 *  size_t numScaled = seen;
+		 *  seen = patternScaler.updateScalers(patternSet, seen);
+		 *  patternScaler.rescale(previous, patternSet, numScaled);
+		 *  \endcode
+		 *  \pre previous.numInputDimensions() == numInputDimensions()
+		 *  \pre previous.numTargetDimensions() == numTargetDimensions()
+		 *  \pre numScaled <= patternSet.pattern_count
+		 *  \param previous the PatternScaler that scaled the first numScaled patterns
+		 *  \param patternSet an PatternSet with numScaled scaled patterns followed by not scaled patterns
+		 *  \param numScaled number of patterns scaled by previous
+		 */
+		void rescale(const PatternScaler& previous, NPP2::PatternSet& patternSet, size_t numScaled) const;
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Restoring the original values from scaled values
 #endif
 		/** \name Restoring the original values from scaled values
@@ -228,6 +444,48 @@ namespace pulse {
 		/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Folding the scaling into a network
+#endif
+		/** \name Folding the scaling into a network
+		 @{ */
+		
+		/** Returns the scaling of every input dimension as scaled value = slopes[i]*value + intercepts[i]. Dimensions whose scaler is not affine (e.g. NormalizeWithFixpoint with different slopes on both sides of the fixpoint) get slope 1 and intercept 0.
+		 *  \param slopes the slopes, resized to numInputDimensions()
+		 *  \param intercepts the intercepts, resized to numInputDimensions()
+		 *  \return the dimensions whose scaler is not affine
+		 */
+		std::vector<size_t> getInputCoefficients(std::vector<double>& slopes, std::vector<double>& intercepts) const;
+		/** Returns the scaling of every target dimension as scaled value = slopes[i]*value + intercepts[i], see getInputCoefficients().
+		 *  \param slopes the slopes, resized to numTargetDimensions()
+		 *  \param intercepts the intercepts, resized to numTargetDimensions()
+		 *  \return the dimensions whose scaler is not affine
+		 */
+		std::vector<size_t> getTargetCoefficients(std::vector<double>& slopes, std::vector<double>& intercepts) const;
+		/** Folds the input scaling into the first layer of a network, so the layer can be fed with not scaled inputs and scaleInput() is not needed: the layer computes weights*x + bias with the scaled inputs x, afterwards it computes the same from the not scaled inputs.
+		 *  The columns of the dimensions that are not affine are not changed, these inputs still have to be scaled (getInputScaler(dimension).scale()).
+		 *  \param weights the weights of the layer, numNeurons rows of numInputDimensions() values
+		 *  \param bias the numNeurons biases of the layer
+		 *  \param numNeurons
+		 *  \return the input dimensions that are not affine
+		 */
+		std::vector<size_t> foldIntoFirstLayer(double* weights, double* bias, size_t numNeurons) const;
+		/** float version of foldIntoFirstLayer(double*, double*, size_t), the new parameters are computed in double */
+		std::vector<size_t> foldIntoFirstLayer(float* weights, float* bias, size_t numNeurons) const;
+		/** Folds the inverse of the target scaling into the last layer of a network, so the layer returns not scaled values and originalTargetValues() is not needed.
+		 *  \pre the last layer is linear (weights*x + bias without an activation function)
+		 *  The rows of the dimensions that are not affine are not changed, these outputs still have to be restored (getTargetScaler(dimension).originalValue()).
+		 *  \param weights the weights of the layer, numTargetDimensions() rows of numHidden values
+		 *  \param bias the numTargetDimensions() biases of the layer
+		 *  \param numHidden number of inputs of the layer
+		 *  \return the target dimensions that are not affine
+		 */
+		std::vector<size_t> foldIntoLastLayer(double* weights, double* bias, size_t numHidden) const;
+		/** float version of foldIntoLastLayer(double*, double*, size_t), the new parameters are computed in double */
+		std::vector<size_t> foldIntoLastLayer(float* weights, float* bias, size_t numHidden) const;
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Dimension informations
 #endif
 		/** \name Dimension informations
@@ -237,6 +495,14 @@ namespace pulse {
 		size_t numInputDimensions() const;
 		/** Returns the number of scalers for the target values of a NPP2::PatternSet */
 		size_t numTargetDimensions() const;
+		/** Returns the scaler of an input dimension
+		 *  \pre dimension < numInputDimensions()
+		 */
+		const Scaler& getInputScaler(size_t dimension) const;
+		/** Returns the scaler of a target dimension
+		 *  \pre dimension < numTargetDimensions()
+		 */
+		const Scaler& getTargetScaler(size_t dimension) const;
 		
 		/*@}*/
 #ifdef __APPLE__
@@ -244,8 +510,22 @@ namespace pulse {
 #endif
 		
 	private:
+		/** Forgets the ranges seen by updateInputScalers(const std::vector<double>&, size_t), called by every path that writes the input scalers without updateInputScaler() */
+		void forgetSeenInputRanges();
+		/** Passes value to the scaler of dimension, unless it lies inside the range the scaler has already seen */
+		void updateInputScaler(size_t dimension, double value);
+		/** Passes num zeros to the scaler of dimension, once through updateInputScaler() if it can be fitted from extrema and with Scaler::updateScalingFactorsRepeated() otherwise */
+		void updateInputScalerZeros(size_t dimension, size_t num);
+		
 		std::vector<Scaler*> m_inputScalers;
 		std::vector<Scaler*> m_targetScalers;
+		/** The ranges of the values updateInputScalers(const std::vector<double>&, size_t) passed to scalers that can be fitted from extrema since their parameters were last written by another path. Values inside do not change the scalers, so whole samples are skipped with a single vectorized test. Empty (min > max) for the other scalers.
+		 *  Invariant: every cached range lies inside the range its scaler covers. Every method that writes the input scalers other than through updateInputScaler() calls forgetSeenInputRanges(), as such a write may shrink the range (reset, merge, block updates, folding extrema).
+		 */
+		std::vector<double> m_inputSeenMin;
+		std::vector<double> m_inputSeenMax;
+		MissingValuePolicy m_missingPolicy;
+		double m_imputedValue;
 	};
 }
 
@@ -0,0 +1,87 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+namespace pulse {
+	/**
+	 * \brief A continuous function made of two linear segments that meet in the pivot:
+	 * f(x) = pivotValue + (x-pivot)*slopeBelow for x < pivot and f(x) = pivotValue + (x-pivot)*slopeAbove otherwise.
+	 * Normalize is the special case slopeBelow == slopeAbove, NormalizeWithFixpoint uses the fixpoint as pivot.
+	 * Both slopes are expected to be positive (all scalers are strictly increasing).
+	 */
+	struct PiecewiseLinear {
+		/** Constructor - the identity */
+		PiecewiseLinear();
+		/** Constructor
+		 *  \pre slopeBelow > 0.0
+		 *  \pre slopeAbove > 0.0
+		 */
+		PiecewiseLinear(double pivot, double pivotValue, double slopeBelow, double slopeAbove);
+		/** Returns the affine function f(x) = slope*x + intercept
+		 *  \pre slope > 0.0
+		 */
+		static PiecewiseLinear affine(double slope, double intercept);
+		
+		/** Evaluates the function */
+		inline double operator()(double x) const {
+			const double d = x - pivot;
+			return pivotValue + d*(d < 0.0 ? slopeBelow : slopeAbove);
+		}
+		/** True if both segments have the same slope */
+		bool isAffine() const;
+		/** Returns the slope of an affine function
+		 *  \pre isAffine()
+		 */
+		double slope() const;
+		/** Returns the value at 0 of an affine function
+		 *  \pre isAffine()
+		 */
+		double intercept() const;
+		/** Returns the inverse function */
+		PiecewiseLinear inverse() const;
+		/** Calculates outer(inner(x)) as a single PiecewiseLinear function. This is possible if at least one of the functions is affine or if the pivot of inner is mapped on the pivot of outer.
+		 *  \param outer the function applied last
+		 *  \param inner the function applied first
+		 *  \param result the composition, only valid if true was returned
+		 *  \return false if the composition has more than two segments
+		 */
+		static bool compose(const PiecewiseLinear& outer, const PiecewiseLinear& inner, PiecewiseLinear& result);
+		
+		double pivot;
+		double pivotValue;
+		double slopeBelow;
+		double slopeAbove;
+	};
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <vector>
+#include <cstddef>
+#include <pulse/MergeException.h>
+
+namespace pulse {
+	/**
+	 * \brief The class QuantileSketch approximates the quantiles of a stream of values with bounded memory (KLL sketch).
+	 * The values are kept in levels, a value on level h stands for 2^(h+s) values of the stream (s is the sample level, see below). If the sketch is full, the lowest full level is sorted and every second value is moved to the next level.
+	 * Compaction alternates between the even and the odd values, so the sketch is deterministic. The number of retained values is below 3*k plus minLevelCapacity values per level, independent of the number of values added.
+	 * New values are collected unsorted in level 0 until the sketch is full, so adding a batch is mostly a copy. Once the lowest levels are at their minimal capacity, level 0 is replaced by sampling one value out of each block of 2^s values.
+	 * The kept value of a block is chosen with a hash of the block number, so the sketch stays deterministic and the cost per value of large streams approaches a pass over the data for the exact minimum and maximum.
+	 * Two sketches can be combined with merge(), e.g. to combine the sketches of different shards.
+	 */
+	class QuantileSketch {
+	public:
+		/** Constructor
+		 *  \pre k >= 8
+		 *  \param k accuracy parameter, the rank error is roughly 1.7/k
+		 */
+		explicit QuantileSketch(size_t k = 200);
+		/** Adds a single value, NaNs are ignored
+		 *  \return true if the sketch compacted
+		 */
+		bool add(double value);
+		/** Adds num copies of value in O(log num): the blocks of the sampling that are covered completely are placed as one value per set bit of their number on the matching levels, NaNs are ignored
+		 *  \return true if the sketch compacted
+		 */
+		bool add(double value, unsigned long long num);
+		/** Adds data[i*offset] with \f$i \in {0...num-1}\f$, NaNs are ignored */
+		void add(double const* data, size_t offset, size_t num);
+		/** Adds data[i][offset] with \f$i \in {0...num-1}\f$, NaNs are ignored */
+		void add(double** const data, size_t offset, size_t num);
+		/** Adds all the values of other
+		 *  \throw MergeException if other.getK() != getK()
+		 */
+		void merge(const QuantileSketch& other);
+		/** Removes all values */
+		void clear();
+		/** Returns the approximate quantile q
+		 *  \pre getCount() > 0
+		 *  \param q in [0,1], 0 and 1 return the exact minimum and maximum
+		 */
+		double getQuantile(double q) const;
+		/** Returns the approximate quantiles q[i] with \f$i \in {0...num-1}\f$ in re with a single pass over the sketch
+		 *  \pre getCount() > 0
+		 *  \pre q is sorted ascending
+		 */
+		void getQuantiles(const double* q, size_t num, double* re) const;
+		/** Returns the number of values that were added */
+		unsigned long long getCount() const;
+		/** Returns the number of values that are stored */
+		size_t getNumRetained() const;
+		size_t getK() const;
+		/** Appends the state to params: k, compactions, count, min, max, sample level, block fill, block pick, number of blocks, number of levels and for every level its size followed by its values */
+		void getParameters(std::vector<double>& params) const;
+		/** Restores the state from params[first...] as written by getParameters()
+		 *  \pre checkParameters(params, first, end)
+		 *  \return the index behind the last parameter of the sketch
+		 */
+		size_t setParameters(const std::vector<double>& params, size_t first);
+		/** Checks that params[first...] holds a sketch as written by getParameters(), i.e. that the counts are valid and that all levels are inside of params
+		 *  \param params
+		 *  \param first
+		 *  \param end is set to the index behind the last parameter of the sketch
+		 *  \return false if setParameters(params, first) would read invalid or missing parameters
+		 */
+		static bool checkParameters(const std::vector<double>& params, size_t first, size_t& end);
+		/** Number of parameters written by getParameters() for an empty sketch */
+		static const size_t numHeaderParameters = 11;
+		/** Minimal capacity of a level, compacting a full sketch frees at least half of it */
+		static const size_t minLevelCapacity = 8;
+	private:
+		/** Capacity of level h with the current number of levels, computed */
+		size_t getLevelCapacity(size_t h) const;
+		/** Capacity of level h with the current number of levels */
+		size_t getCapacity(size_t h) const;
+		/** Compacts levels until the sketch is below its capacity */
+		void compress();
+		/** Moves every second value of level h to level h+1 */
+		void compact(size_t h);
+		/** Updates m_capacities after the number of levels changed */
+		void updateCapacity();
+		/** Compacts level 0 completely and replaces it by sampling with the next sample level */
+		void increaseSampleLevel();
+		/** Starts the next block of the sampling */
+		void nextBlock();
+		template<class Accessor>
+		void addBatch(const Accessor& data, size_t num);
+		
+		size_t m_k;
+		std::vector<std::vector<double> > m_levels;
+		/** Number of stored values */
+		size_t m_size;
+		/** Capacities of the levels */
+		std::vector<size_t> m_capacities;
+		/** Sum of the capacities of all levels */
+		size_t m_capacity;
+		unsigned long long m_count;
+		unsigned long long m_compactions;
+		/** Values on level 0 stand for 2^m_sampleLevel values */
+		size_t m_sampleLevel;
+		/** Number of values of the current block that were seen */
+		size_t m_blockFill;
+		/** Index of the value of the current block that is kept */
+		size_t m_blockPick;
+		unsigned long long m_numBlocks;
+		double m_min;
+		double m_max;
+	};
+}
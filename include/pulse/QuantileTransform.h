@@ -0,0 +1,118 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+#include <pulse/QuantileSketch.h>
+
+namespace pulse {
+	/**
+	 * \brief The class QuantileTransform maps values through a piecewise linear approximation of their cumulative distribution function.
+	 * The knots are K quantiles of the seen values at i/(K-1) with \f$i \in {0...K-1}\f$, knot i is scaled to minNorm + i*(maxNorm-minNorm)/(K-1). Values between the knots are interpolated, values outside of the first and last knot are extrapolated with the slope of the first and last segment (like NormalizeWithFixpoint, which is the same map with three knots).
+	 * The quantiles are taken from a QuantileSketch, so the memory is bounded independent of the number of updates. The knots are updated after every batch update. Single value updates only update them when the sketch compacts and after 1, 2, 4, 8, ... values, in between the scaling uses the knots of an earlier update. Call updateKnots() before scaling to use the quantiles of all values seen so far.
+	 * The batch scaling finds the segment of a value by counting the knots that are not bigger than the value, without branches so the compiler can vectorize it. The knots are counted in two stages, first the first knots of groups of 8 knots for a block of values, then the knots of the group of every value, K=64 needs 15 compares per value.
+	 */
+	class QuantileTransform : public Scaler {
+	public:
+		/** Constructor - the knots are evenly spaced in [0,1] until the first update
+		 *  \pre minNorm < maxNorm
+		 *  \pre numKnots >= 2
+		 *  \param minNorm
+		 *  \param maxNorm
+		 *  \param numKnots number of knots K
+		 *  \param sketchSize accuracy parameter k of the QuantileSketch
+		 */
+		QuantileTransform(double minNorm, double maxNorm, size_t numKnots = 64, size_t sketchSize = 200);
+		virtual ~QuantileTransform() {}
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		/** Adds value to the sketch, the knots lag behind, see updateKnots() */
+		virtual void updateScalingFactors(double value);
+		/** Adds num copies of value to the sketch with a weighted insert, see QuantileSketch::add(double, unsigned long long) */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		/** Only possible with two knots */
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		/** The parameters are minNorm, maxNorm, K, the K knots followed by the parameters of the QuantileSketch */
+		virtual void getParameters(std::vector<double>& params) const;
+		/** \pre checkParameters(params) */
+		virtual void setParameters(const std::vector<double>& params);
+		/** Returns false if params are no parameters written by getParameters(), e.g. those of a truncated file */
+		static bool checkParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** Combines the sketch of other into this and fits the knots again.
+		 *  \throw MergeException if other is no QuantileTransform or has another norm range, number of knots or sketch size
+		 *  \param other
+		 */
+		virtual void merge(const Scaler& other);
+		/** Returns the knots */
+		const std::vector<double>& getKnots() const;
+		const QuantileSketch& getSketch() const;
+		/** Determines the knots from the quantiles of the sketch, the batch updates call it, after single value updates it has to be called to scale with up to date knots */
+		void updateKnots();
+	private:
+		/** Updates the segments after the knots changed */
+		void updateSegments();
+		/** Returns the segment of value */
+		inline size_t findSegment(double value) const;
+		template<class Input, class Output>
+		void transform(const Input& in, const Output& out, size_t num) const;
+		
+		QuantileSketch m_sketch;
+		double m_minNorm;
+		double m_maxNorm;
+		/** Difference of the scaled values of two knots */
+		double m_step;
+		std::vector<double> m_knots;
+		/** scaled value of the first knot of every segment */
+		std::vector<double> m_segmentValue;
+		/** slope of every segment */
+		std::vector<double> m_slope;
+		/** 1/slope of every segment */
+		std::vector<double> m_inverseSlope;
+		/** The inner knots, padded with infinity to full groups */
+		std::vector<double> m_searchKnots;
+		/** The first knot of every group of m_searchKnots except the first group */
+		std::vector<double> m_groupKnots;
+		static std::string m_name;
+	};
+}
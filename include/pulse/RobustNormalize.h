@@ -0,0 +1,107 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+#include <pulse/QuantileSketch.h>
+
+namespace pulse {
+	/**
+	 * \brief The class RobustNormalize scales the range between two quantiles of the seen values (e.g. p1 and p99) to [minNorm, maxNorm], so single outliers do not compress the range of all other values.
+	 * The quantiles are approximated with a QuantileSketch, the memory is bounded independent of the number of updates. Values outside the quantile range can optionally be clipped to [minNorm, maxNorm].
+	 * The range is updated after every batch update. Single value updates only update it when the sketch compacts and after 1, 2, 4, 8, ... values, as a refresh queries the sketch. In between scale() uses the range of an earlier update, call updateRange() before scaling to use the quantiles of all values seen so far.
+	 */
+	class RobustNormalize : public Scaler {
+	public:
+		/** Constructor
+		 *  \pre minNorm < maxNorm
+		 *  \pre 0 <= lowerQuantile < upperQuantile <= 1
+		 *  \param minNorm the scaled value of the lower quantile
+		 *  \param maxNorm the scaled value of the upper quantile
+		 *  \param lowerQuantile
+		 *  \param upperQuantile
+		 *  \param clip if true scaled values are clipped to [minNorm, maxNorm]
+		 *  \param sketchSize accuracy parameter k of the QuantileSketch
+		 */
+		RobustNormalize(double minNorm, double maxNorm, double lowerQuantile = 0.01, double upperQuantile = 0.99, bool clip = false, size_t sketchSize = 200);
+		virtual ~RobustNormalize() {}
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		/** Adds value to the sketch, the range lags behind, see updateRange() */
+		virtual void updateScalingFactors(double value);
+		/** Adds num copies of value to the sketch with a weighted insert, see QuantileSketch::add(double, unsigned long long) */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		/** Clipped values can not be restored, they are returned as the value of the quantile */
+		virtual double originalValue(double value) const;
+		/** Only possible without clipping */
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		/** The parameters are lowerQuantile, upperQuantile, minNorm, maxNorm, clip followed by the parameters of the QuantileSketch */
+		virtual void getParameters(std::vector<double>& params) const;
+		/** \pre checkParameters(params) */
+		virtual void setParameters(const std::vector<double>& params);
+		/** Returns false if params are no parameters written by getParameters(), e.g. those of a truncated file */
+		static bool checkParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** Combines the sketch of other into this.
+		 *  \throw MergeException if other is no RobustNormalize or has other quantiles, norm range, clipping or sketch size
+		 *  \param other
+		 */
+		virtual void merge(const Scaler& other);
+		/** Returns the value of the lower quantile that is scaled to minNorm */
+		double getLower() const;
+		/** Returns the value of the upper quantile that is scaled to maxNorm */
+		double getUpper() const;
+		const QuantileSketch& getSketch() const;
+		/** Determines the range from the quantiles of the sketch, the batch updates call it, after single value updates it has to be called to scale with an up to date range */
+		void updateRange();
+	private:
+		QuantileSketch m_sketch;
+		double m_lowerQuantile;
+		double m_upperQuantile;
+		double m_lower;
+		double m_upper;
+		double m_minNorm;
+		double m_maxNorm;
+		bool m_clip;
+		static std::string m_name;
+	};
+}
@@ -40,8 +40,22 @@
 #include <vector>
 #include <cstddef>
 #include <string>
+#include <pulse/PiecewiseLinear.h>
+#include <pulse/MergeException.h>
 
 namespace pulse {
+	/**
+	 * How a scaler treats missing values, i.e. NaN and infinite values.
+	 */
+	enum MissingValuePolicy {
+		/** No checks, missing values are handled like any other value by the fit and the scaling (default) */
+		PropagateMissing,
+		/** Missing values are skipped by the fit and are passed through by the scaling */
+		SkipMissing,
+		/** Missing values are skipped by the fit and are replaced by the imputed value by the scaling */
+		ImputeMissing
+	};
+	
 	/**
 	 * A scaler scales double values to a target value range. 
 	 * @note Before scaling any new data you should always call a update* or reset* methods. This makes sure that no new previosly unseen values result in a value that is outside the target value range.
@@ -93,6 +107,14 @@ namespace pulse {
 		 *  \param value the unscaled value
 		 */
 		virtual void updateScalingFactors(double value) = 0;
+		/**
+		 *  Updates the scaling parameters as if value was passed num times in a row, e.g. for the implicit zeros of sparse patterns.
+		 *  The default passes value once to scalers that can be fitted from extrema (see isExtremaSufficient()) and as a block with stride 0 to the others, scalers override it with a closed form that does not depend on num.
+		 *  \pre num > 0
+		 *  \param value the unscaled value
+		 *  \param num number of copies
+		 */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
 		
 		/*@}*/
 #ifdef __APPLE__
@@ -174,6 +196,109 @@ namespace pulse {
 		/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Single precision scaling
+#endif
+		/** \name Single precision scaling
+		 @{ */
+
+		/**
+		 * Scales float values, e.g. input buffers of a network working in single precision. The parameters stay in double, the default implementation evaluates getPiecewiseLinear() in float if possible and scale() otherwise. Both impute missing values like scale(), see getMissingValuePolicy().
+		 * The data is beeing accessed the following way: in[inOffset*i] and out[outOffset*i] with \f$i \in {0...num-1}\f$
+		 * \param in
+		 * \param inOffset
+		 * \param out
+		 * \param outOffset
+		 * \param num number of entries
+		 */
+		virtual void scaleFloats(float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const;
+		/**
+		 * Scales double values and writes them out as float. The scaling is computed in double, so every value is only rounded once. Missing values are imputed like by scale(), see getMissingValuePolicy().
+		 * The data is beeing accessed the following way: in[inOffset*i] and out[outOffset*i] with \f$i \in {0...num-1}\f$
+		 * \param in
+		 * \param inOffset
+		 * \param out
+		 * \param outOffset
+		 * \param num number of entries
+		 */
+		virtual void scaleToFloats(double const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const;
+		/**
+		 * Takes scaled float values (e.g. outputs of a network) and returns the original non scaled values.
+		 * The data is beeing accessed the following way: in[inOffset*i] and out[outOffset*i] with \f$i \in {0...num-1}\f$
+		 * \param in
+		 * \param inOffset
+		 * \param out
+		 * \param outOffset
+		 * \param num number of entries
+		 */
+		virtual void originalFloatValues(float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const;
+
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Rescaling of scaled data
+#endif
+		/** \name Rescaling of scaled data
+		 @{ */
+
+		/**
+		 * Transforms values that were scaled by previous into the values this scaler produces for the same original values, so data does not have to be kept unscaled to follow updates of the scaling parameters.
+		 * The default implementation applies getRescaling() if possible and scale(previous.originalValue(x)) otherwise, missing values are imputed like by scale().
+		 * The data is beeing accessed the following way: data[i*offset] with \f$i \in {0...num-1}\f$
+		 * \param previous the scaler that scaled the data, usually a clone of this scaler taken before an update
+		 * \param data ptr to the data scaled by previous
+		 * \param offset
+		 * \param num number of entries
+		 */
+		virtual void rescale(const Scaler& previous, double* data, size_t offset, size_t num) const;
+		/**
+		 * Transforms values that were scaled by previous into the values this scaler produces for the same original values.
+		 * The data is beeing accessed the following way: data[i][offset] with \f$i \in {0...num-1}\f$
+		 * \param previous the scaler that scaled the data, usually a clone of this scaler taken before an update
+		 * \param data ptr to the data scaled by previous
+		 * \param offset
+		 * \param num number of entries
+		 */
+		virtual void rescale(const Scaler& previous, double** data, size_t offset, size_t num) const;
+		/**
+		 * Describes the rescaling from previous to this scaler as a PiecewiseLinear function: the scaling of this composed with the inverse of the scaling of previous.
+		 * For Normalize this is an affine function, for NormalizeWithFixpoint a function with the kink at the scaled fixpoint.
+		 * \param previous the scaler that scaled the data
+		 * \param function the rescaling function, only valid if true was returned
+		 * \return false if one of the scalings is not a PiecewiseLinear function or the composition has more than two segments
+		 */
+		bool getRescaling(const Scaler& previous, PiecewiseLinear& function) const;
+
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Describing the scaling function
+#endif
+		/** \name Describing the scaling function
+		 @{ */
+
+		/**
+		 * Describes the scaling with the current parameters as a PiecewiseLinear function. This allows to fuse the scaling into other code (e.g. generated code).
+		 * \param function the scaling function, only valid if true was returned
+		 * \return false if the scaling can not be expressed as a PiecewiseLinear function (default)
+		 */
+		virtual bool getPiecewiseLinear(PiecewiseLinear& /*function*/) const { return false; }
+		/**
+		 * True if resetting the scaler with only the minimum and the maximum of some data results in the same parameters as resetting it with all of the data (e.g. Normalize). Such scalers can be fitted from precomputed extrema, see PatternRangeIndex.
+		 * \return false if the fit depends on more than the extrema (default)
+		 */
+		virtual bool isExtremaSufficient() const { return false; }
+		/**
+		 * Returns the value range the scaler scales the data to, e.g. to derive the parameters of a quantization of the scaled values (see PatternQuantizer).
+		 * \note Values outside of the fitted data can be scaled to values outside of the range.
+		 * \param minNorm the lower bound, only valid if true was returned
+		 * \param maxNorm the upper bound, only valid if true was returned
+		 * \return false if the scaled values are not bounded (default)
+		 */
+		virtual bool getNormRange(double& /*minNorm*/, double& /*maxNorm*/) const { return false; }
+
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Saving and loading functionality
 #endif
 		/** \name Saving and loading functionality
@@ -198,6 +323,74 @@ namespace pulse {
 		/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Merging of fitted scalers
+#endif
+		/** \name Merging of fitted scalers
+		 @{ */
+		
+		/**
+		 * Combines the fitted state of other into this scaler. Afterwards the scaler is in the state it would have after seeing the values of both, so shards of the data can be fitted independently (e.g. in different processes) and merged afterwards.
+		 * The default throws a MergeException, scalers that can be merged override it.
+		 * \throw MergeException if other has another type or another configuration (e.g. another norm range), the scaler is not changed then
+		 * \param other the scaler that is merged into this one
+		 */
+		virtual void merge(const Scaler& other);
+		
+		/*@}*/
+	protected:
+		/**
+		 * Throws a MergeException if other has another type or another norm range, called by the merge methods before they check the rest of their configuration.
+		 * \param other
+		 */
+		void checkMergeable(const Scaler& other) const;
+	public:
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Concurrent scaling
+#endif
+		/** \name Concurrent scaling
+		 @{ */
+		
+		/**
+		 * Enables or disables the concurrent mode. In the concurrent mode one thread can update the scaler while other threads scale with it: the updates are published with a SeqLock and every call of a const method works on a consistent set of parameters, without locks on either side.
+		 * \note Updates still have to come from one thread at a time. The mode has to be set before the scaler is shared between threads.
+		 * \param concurrent
+		 * \return false if the scaler does not support the concurrent mode (default)
+		 */
+		virtual bool setConcurrent(bool /*concurrent*/) { return false; }
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Missing values
+#endif
+		/** \name Missing values
+		 @{ */
+		
+		/**
+		 * Sets how NaN and infinite values are treated by the update, reset and scale methods. The checks are part of the fit and scale loops, so they do not cost an additional pass over the data.
+		 * \note The policy is a setting and not a parameter, it is not saved and has to be set before the scaler is shared between threads.
+		 * \param policy
+		 * \param imputedValue the scaled value missing values are replaced with by ImputeMissing
+		 * \return false if the scaler does not support the policy (default: only PropagateMissing is supported)
+		 */
+		virtual bool setMissingValuePolicy(MissingValuePolicy policy, double /*imputedValue*/ = 0.0) { return policy == PropagateMissing; }
+		
+		/**
+		 * Returns the policy set with setMissingValuePolicy(). Code that scales with the PiecewiseLinear function of a scaler instead of its scale methods, like the default single precision and rescaling methods, uses it to impute like the scale methods do.
+		 * \param imputedValue is set to the imputed value, if the policy is ImputeMissing
+		 * \return PropagateMissing by default
+		 */
+		virtual MissingValuePolicy getMissingValuePolicy(double& /*imputedValue*/) const { return PropagateMissing; }
+		
+		/**
+		 * Returns the number of missing values skipped by the update and reset methods since the construction. Only counted by SkipMissing and ImputeMissing.
+		 */
+		virtual size_t getMissingCount() const { return 0; }
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Cloning
 #endif
 		/** \name Cloning
@@ -0,0 +1,120 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+
+#include <vector>
+#include <pulse/Scaler.h>
+
+namespace pulse {
+	/**
+	 * \brief The class ScalerChain applies an ordered chain of scalers, scale(x) = s_n(...s_2(s_1(x))).
+	 * Every scaler of the chain is fitted on the values scaled by the scalers before it. After every fit the chain is compiled into stages: adjacent scalers that can be described as PiecewiseLinear functions are composed into one function (see PiecewiseLinear::compose()), so scaling with a chain of Normalize scalers is a single pass over the data. Only the scalers that are not PiecewiseLinear functions are applied as separate stages.
+	 * The missing value policies of the scalers are kept by the composed functions: if a composed scaler imputes, its imputed value is scaled by the functions composed after it.
+	 * ScalerSaver writes the chain as a line with the number of scalers followed by one line per scaler with the ids id.1, id.2, ..., ScalerFactory restores it from these lines.
+	 * \note The update methods update every scaler with the values scaled by the already updated scalers before it, values seen earlier are not scaled again.
+	 */
+	class ScalerChain : public Scaler {
+	public:
+		/** Constructor - the empty chain, which does not change the values */
+		ScalerChain();
+		ScalerChain(const ScalerChain& other);
+		ScalerChain& operator=(const ScalerChain& other);
+		virtual ~ScalerChain();
+		
+		/** Appends a copy of scaler to the chain */
+		void addScaler(const Scaler& scaler);
+		/** Returns the number of scalers in the chain */
+		size_t numScalers() const;
+		/** Returns the scaler at position i
+		 *  \pre i < numScalers()
+		 */
+		const Scaler& getScaler(size_t i) const;
+		/** Returns the number of passes scaling needs after the PiecewiseLinear scalers were composed */
+		size_t numStages() const;
+		
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double value);
+		/** Passes num copies of value to the first scaler and num copies of the scaled value to every following one, like the block updates */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		/** Possible if all scalers were composed into one stage */
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		/** True if all scalers can be fitted from extrema, the scalers are increasing so the extrema of the scaled values are the scaled extrema */
+		virtual bool isExtremaSufficient() const;
+		/** ImputeMissing if all scalers were composed into one stage that imputes, see getPiecewiseLinear() */
+		virtual MissingValuePolicy getMissingValuePolicy(double& imputedValue) const;
+		/** The norm range of the last scaler */
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		/** The parameters are the number of scalers followed by the number of parameters and the parameters of every scaler */
+		virtual void getParameters(std::vector<double>& params) const;
+		/** \pre the chain has the scalers the parameters were taken from */
+		virtual void setParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** Merges the first scaler of other into the first scaler and refits the later scalers with the extrema of the merged values scaled by the scalers in front of them, so the chain is in the state of a reset with the values of both chains.
+		 *  The later scalers can not be merged position by position, they were fitted on values scaled with different parameters.
+		 *  \throw MergeException if other is no ScalerChain, has another length, if a scaler of one of the chains can not be fitted from extrema (see isExtremaSufficient()) or if two scalers at the same position can not be merged
+		 *  \param other
+		 */
+		virtual void merge(const Scaler& other);
+	private:
+		/** A composed PiecewiseLinear function (scaler == 0) or a scaler that is applied on its own */
+		struct Stage {
+			PiecewiseLinear function;
+			PiecewiseLinear inverse;
+			const Scaler* scaler;
+			/** True if the composed function replaces missing values by imputedValue */
+			bool impute;
+			double imputedValue;
+		};
+		/** Compiles the scalers into m_stages, called after every change of the parameters */
+		void updateStages();
+		/** Fits the scalers one after another on values, which are scaled by each scaler before they are passed on */
+		void fit(std::vector<double>& values, bool reset);
+		void clear();
+		
+		std::vector<Scaler*> m_scalers;
+		std::vector<Stage> m_stages;
+		static std::string m_name;
+	};
+}
@@ -43,7 +43,9 @@
 #include <pulse/ParseException.h>
 
 namespace pulse {
-	/** Loads Normalize or NormalizeWithFixpoint scalers from a file */
+	class CSVReader;
+	
+	/** Loads scalers saved by ScalerSaver (Normalize, NormalizeWithFixpoint, SlidingWindowNormalize, ExponentialDecayNormalize, Standardize, RobustNormalize, QuantileTransform, Log1pNormalize, SignedLogNormalize, TanhNormalize or a ScalerChain of these) from a file */
 	class ScalerFactory {
 	public:
 		ScalerFactory(const std::string& file);
@@ -51,6 +53,9 @@ namespace pulse {
 		size_t getMaxId(const std::string& prefix) throw (FileOpenException, ParseException);
 		Scaler* getScaler(const std::string& id) throw (FileOpenException, ParseException);
 	private:
+		Scaler* loadScaler(const std::string& id) throw (FileOpenException, ParseException);
+		/** Reads the number of scalers of a chain from the current line and loads the scalers from the lines id.1, id.2, ... */
+		Scaler* loadChain(const std::string& id, CSVReader& reader) throw (FileOpenException, ParseException);
 		std::string m_filePath;
 	};
 }
\ No newline at end of file
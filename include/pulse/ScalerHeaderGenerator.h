@@ -0,0 +1,71 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <pulse/PiecewiseLinear.h>
+#include <pulse/FileOpenException.h>
+#include <pulse/ParseException.h>
+
+namespace pulse {
+	/** Generates a C++ header from a file written by PatternScaler::saveToFile.
+	 *  The header contains the scaling parameters as constexpr arrays and inline scaleInput / originalTargetValues functions without branches, so no parameter file has to be loaded at runtime.
+	 *  All scalers in the file have to support Scaler::getPiecewiseLinear.
+	 */
+	class ScalerHeaderGenerator {
+	public:
+		/** Loads the scalers of a file written by PatternScaler::saveToFile
+		 *  \param scalerFile
+		 */
+		ScalerHeaderGenerator(const std::string& scalerFile) throw (FileOpenException, ParseException);
+		virtual ~ScalerHeaderGenerator();
+		/** Writes the header
+		 *  \param out
+		 *  \param ns the namespace that contains the generated arrays and functions
+		 */
+		void write(std::ostream& out, const std::string& ns) const;
+		/** Writes the header into a file
+		 *  \param filename
+		 *  \param ns the namespace that contains the generated arrays and functions
+		 */
+		void writeToFile(const std::string& filename, const std::string& ns) const throw (FileOpenException);
+	private:
+		std::string m_scalerFile;
+		std::vector<PiecewiseLinear> m_inputFunctions;
+		std::vector<PiecewiseLinear> m_targetFunctions;
+	};
+}
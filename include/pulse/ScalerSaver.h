@@ -44,12 +44,12 @@
 #include <pulse/FileOpenException.h>
 
 namespace pulse {
-	/** Saves given scalers into a textfile using getTypeName() and getParameters() */
+	/** Saves given scalers into a textfile using getTypeName() and getParameters(), a ScalerChain is saved as the number of its scalers followed by a line for every scaler with the ids id.1, id.2, ... */
 	class ScalerSaver {
 	public:
 		ScalerSaver(const std::string& filename) throw(FileOpenException);
 		virtual ~ScalerSaver();
-		void saveScaler(const std::string& id, Scaler* scaler);
+		void saveScaler(const std::string& id, const Scaler* scaler);
 	private:
 		std::ofstream m_ofstream;
 		std::string m_seperator;
@@ -0,0 +1,73 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <stdint.h>
+#include <pulse/PiecewiseLinear.h>
+
+namespace pulse {
+	/**
+	 * \brief The class ScalingTable interns PiecewiseLinear functions: every distinct function is stored once and referenced by its index.
+	 * Functions are equal if their parameters have the same bits. One table can be shared by the InternedPatternScalers of several models, so dimensions with the same fitted parameters (e.g. all one-hot inputs scaled from [0,1]) share one entry across dimensions and models.
+	 * \note Interning is not thread safe, the table must not be changed while it is used for scaling in other threads.
+	 */
+	class ScalingTable {
+	public:
+		ScalingTable();
+		
+		/** Returns the index of function, it is added if the table does not contain it yet */
+		uint32_t intern(const PiecewiseLinear& function);
+		/** Returns the function at index
+		 *  \pre index < size()
+		 */
+		const PiecewiseLinear& get(uint32_t index) const;
+		/** Returns the number of distinct functions */
+		size_t size() const;
+	private:
+		/** The bits of pivot, pivotValue, slopeBelow and slopeAbove */
+		struct Key {
+			uint64_t bits[4];
+			bool operator<(const Key& other) const;
+		};
+		
+		std::vector<PiecewiseLinear> m_functions;
+		std::map<Key, uint32_t> m_indices;
+	};
+}
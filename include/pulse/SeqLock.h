@@ -0,0 +1,118 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace pulse {
+	/**
+	 * \brief The class SeqLock publishes a value of a trivially copyable type T from one writer to any number of readers without locks.
+	 * The writer makes the sequence number odd, stores the value word by word and makes the sequence number even again. A reader copies the value and retries if the sequence number was odd or has changed, so it never returns a torn value and the writer never waits for readers.
+	 * The words are relaxed atomics, so concurrent reads and writes are not a data race in the sense of the C++ memory model.
+	 * \note Writers have to be serialized by the caller, e.g. by updating from a single thread.
+	 */
+	template<class T>
+	class SeqLock {
+	public:
+		/** Constructor - the value is zero initialized */
+		SeqLock() :
+			m_sequence(0)
+		{
+			for (size_t i = 0; i < numWords; i++) {
+				m_words[i].store(0, std::memory_order_relaxed);
+			}
+		}
+		/** Constructor
+		 *  \param value the initial value
+		 */
+		explicit SeqLock(const T& value) :
+			m_sequence(0)
+		{
+			store(value);
+		}
+		/** Copy constructor - copies a consistent value of other */
+		SeqLock(const SeqLock& other) :
+			m_sequence(0)
+		{
+			store(other.load());
+		}
+		/** Copy operation - publishes a consistent value of other */
+		SeqLock& operator=(const SeqLock& other) {
+			store(other.load());
+			return *this;
+		}
+		
+		/** Publishes value
+		 *  \note must not be called concurrently with other calls of store
+		 */
+		void store(const T& value) {
+			uint64_t words[numWords];
+			memcpy(words, &value, sizeof(T));
+			const unsigned long sequence = m_sequence.load(std::memory_order_relaxed);
+			m_sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t i = 0; i < numWords; i++) {
+				m_words[i].store(words[i], std::memory_order_relaxed);
+			}
+			m_sequence.store(sequence + 2, std::memory_order_release);
+		}
+		/** Returns the last published value, can be called concurrently with store */
+		T load() const {
+			uint64_t words[numWords];
+			unsigned long before;
+			unsigned long after;
+			do {
+				before = m_sequence.load(std::memory_order_acquire);
+				for (size_t i = 0; i < numWords; i++) {
+					words[i] = m_words[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				after = m_sequence.load(std::memory_order_relaxed);
+			} while ((before & 1) != 0 || before != after);
+			T re;
+			memcpy(&re, words, sizeof(T));
+			return re;
+		}
+	private:
+		static const size_t numWords = (sizeof(T) + sizeof(uint64_t) - 1)/sizeof(uint64_t);
+		
+		std::atomic<unsigned long> m_sequence;
+		std::atomic<uint64_t> m_words[numWords];
+	};
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <deque>
+#include <pulse/Scaler.h>
+
+namespace pulse {
+	/**
+	 * \brief The class SlidingWindowNormalize linearly scales the values to the boundry values m_minNorm and m_maxNorm like Normalize, but the minimum and maximum are only determined over the last windowSize values passed to the update methods.
+	 * This way old outliers stop influencing the scaling once they left the window. The minimum and maximum are tracked with two monotonic deques, so every update costs O(1) amortized and the memory is bounded by windowSize.
+	 * \note Values outside of the current range are scaled to values outside of [m_minNorm, m_maxNorm] without a warning, as this is expected for drifting data.
+	 */
+	class SlidingWindowNormalize : public Scaler {
+	public:
+		/** Constructor
+		 *  \note the range is [0,1] until the first update or reset
+		 *  \pre minNorm < maxNorm
+		 *  \pre windowSize > 0
+		 *  \param minNorm the minimal double value of a scaled value
+		 *  \param maxNorm the maximal double value of a scaled value
+		 *  \param windowSize the number of most recent values that determine the minimum and maximum
+		 */
+		SlidingWindowNormalize(double minNorm, double maxNorm, size_t windowSize);
+		/** Constructor
+		 *  \pre minNorm < maxNorm
+		 *  \pre seenMin < seenMax
+		 *  \pre windowSize > 0
+		 *  \param minNorm the minimal double value of a scaled value
+		 *  \param maxNorm the maximal double value of a scaled value
+		 *  \param windowSize the number of most recent values that determine the minimum and maximum
+		 *  \param seenMin treated as the minimum of the most recent value
+		 *  \param seenMax treated as the maximum of the most recent value
+		 */
+		SlidingWindowNormalize(double minNorm, double maxNorm, size_t windowSize, double seenMin, double seenMax);
+		virtual ~SlidingWindowNormalize() {}
+		/** \note if num is bigger than the window size only the last windowSize values are read */
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		/** \note if num is bigger than the window size only the last windowSize values are read */
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double value);
+		/** Pushes value once at the position of the last copy, the copies before it can never be the minimum or maximum of a window without it */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		/** The parameters are min, max, minNorm, maxNorm and the window size. The values of the window are not part of the parameters, setParameters treats the range [min, max] as the most recent value. */
+		virtual void getParameters(std::vector<double>& params) const;
+		virtual void setParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** The windows can not be combined exactly, the range of other is added as the most recent value (like setParameters())
+		 *  \throw MergeException if other is no SlidingWindowNormalize or has another norm range or window size
+		 */
+		virtual void merge(const Scaler& other);
+		/** Returns the number of most recent values that determine the minimum and maximum */
+		size_t getWindowSize() const;
+	private:
+		struct Entry {
+			unsigned long index;
+			double value;
+		};
+		/** Adds a value to the window without updating m_min and m_max. NaN takes a position in the window like the values passed by skip(), but is no candidate. */
+		inline void push(double value);
+		/** Adds a range as one value to the window, so it is the most recent minimum and maximum even if the window size is 1 */
+		void pushRange(double min, double max);
+		/** Drops the candidates that left the window when the value at index was added */
+		inline void expire(unsigned long index);
+		/** Skips num values, all values currently in the window expire */
+		void skip(unsigned long num);
+		/** Discards all values of the window */
+		void clear();
+		/** Sets m_min and m_max to the extrema of the window */
+		void updateRange();
+		
+		/** candidates for the minimum, increasing values */
+		std::deque<Entry> m_minCandidates;
+		/** candidates for the maximum, decreasing values */
+		std::deque<Entry> m_maxCandidates;
+		unsigned long m_numSeen;
+		size_t m_windowSize;
+		double m_min;
+		double m_max;
+		double m_minNorm;
+		double m_maxNorm;
+		static std::string m_name;
+	};
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+
+namespace pulse {
+	/**
+	 * \brief The class Standardize scales values to their z-score (value-mean)/deviation, where mean and deviation are determined over all values passed to the update methods.
+	 * The state is the number of values, the mean and the sum of squared differences from the mean (Welford). Two states can be combined exactly with merge() (Chan et al.), so partial fits of different threads or of different shards of the data can be reduced into the fit of all data.
+	 */
+	class Standardize : public Scaler {
+	public:
+		/** Constructor - scales with mean 0 and deviation 1 until the first update or reset */
+		Standardize();
+		/** Constructor
+		 *  \pre count > 0
+		 *  \pre deviation > 0
+		 *  \param count number of values the mean and the deviation were determined from
+		 *  \param mean
+		 *  \param deviation the population standard deviation
+		 */
+		Standardize(double count, double mean, double deviation);
+		virtual ~Standardize() {}
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double value);
+		/** Combines num copies of value with the moments (Chan et al.) */
+		virtual void updateScalingFactorsRepeated(double value, size_t num);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		virtual bool getPiecewiseLinear(PiecewiseLinear& function) const;
+		/** The parameters are count, mean and the sum of squared differences from the mean */
+		virtual void getParameters(std::vector<double>& params) const;
+		virtual void setParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** Combines the state of other into this, afterwards this is in the state it would have if it had seen the values of both.
+		 *  \throw MergeException if other is no Standardize
+		 *  \param other
+		 */
+		virtual void merge(const Scaler& other);
+		virtual bool setMissingValuePolicy(MissingValuePolicy policy, double imputedValue = 0.0);
+		virtual MissingValuePolicy getMissingValuePolicy(double& imputedValue) const;
+		virtual size_t getMissingCount() const;
+		/** Returns the mean */
+		double getMean() const;
+		/** Returns the population standard deviation */
+		double getDeviation() const;
+	private:
+		/** Adds the statistics of a block of values (Chan et al.) */
+		void combine(double count, double mean, double m2);
+		/** Updates m_inverseDeviation */
+		void updateCoefficients();
+		template<class Accessor>
+		void update(const Accessor& data, size_t num);
+		
+		double m_count;
+		double m_mean;
+		double m_m2;
+		/** 1/deviation, 1 if the deviation is 0 */
+		double m_inverseDeviation;
+		MissingValuePolicy m_missingPolicy;
+		double m_imputedValue;
+		size_t m_missingCount;
+		static std::string m_name;
+	};
+}
@@ -0,0 +1,402 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstddef>
+#include <npp2.h>
+#include <PatternSet.h>
+#include <pulse/Scaler.h>
+#include <pulse/ScalerFactory.h>
+#include <pulse/FileOpenException.h>
+#include <pulse/ParseException.h>
+
+namespace pulse {
+	/**
+	 * \brief Non virtual counterpart of Normalize for the use in a StaticPatternScaler.
+	 * All scaling methods are constexpr, so if the parameters are known at compile time the scaled values can be computed by the compiler.
+	 * \note The slope is precomputed, which means the results can differ from Normalize in the last bits.
+	 */
+	class StaticNormalize {
+	public:
+		/** Number of parameters expected by setParameters (same layout as Normalize::getParameters) */
+		static const size_t numParameters = 4;
+		
+		/** Constructor, scales [0,1] to [0,1] until setParameters is called */
+		constexpr StaticNormalize() :
+			m_min(0.0),
+			m_minNorm(0.0),
+			m_slope(1.0),
+			m_inverseSlope(1.0)
+		{}
+		/** Constructor
+		 *  \pre minNorm < maxNorm
+		 *  \pre seenMin < seenMax
+		 *  \param minNorm the minimal double value of all scaled values
+		 *  \param maxNorm the maximal double value of all scaled values
+		 *  \param seenMin the minimal double value of all not scaled values
+		 *  \param seenMax the maximal double value of all not scaled values
+		 */
+		constexpr StaticNormalize(double minNorm, double maxNorm, double seenMin, double seenMax) :
+			m_min(seenMin),
+			m_minNorm(minNorm),
+			m_slope((maxNorm-minNorm)/(seenMax-seenMin)),
+			m_inverseSlope((seenMax-seenMin)/(maxNorm-minNorm))
+		{}
+		/** Scales a single value */
+		constexpr double scale(double value) const {
+			return (value-m_min)*m_slope + m_minNorm;
+		}
+		/** Takes a scaled value and returns the original non scaled value. */
+		constexpr double originalValue(double value) const {
+			return (value-m_minNorm)*m_inverseSlope + m_min;
+		}
+		/** Restores the parameters written by Normalize::getParameters()
+		 *  \pre params.size() == numParameters
+		 */
+		void setParameters(const std::vector<double>& params) {
+			*this = StaticNormalize(params[2], params[3], params[0], params[1]);
+		}
+		/** Returns the type name of the matching Scaler (used to validate parameter files) */
+		static const char* typeName() {
+			return "Normalize";
+		}
+	private:
+		double m_min;
+		double m_minNorm;
+		double m_slope;
+		double m_inverseSlope;
+	};
+	
+	/**
+	 * \brief Non virtual counterpart of NormalizeWithFixpoint for the use in a StaticPatternScaler.
+	 * All scaling methods are constexpr, so if the parameters are known at compile time the scaled values can be computed by the compiler.
+	 * \note The slopes are precomputed, which means the results can differ from NormalizeWithFixpoint in the last bits.
+	 */
+	class StaticNormalizeWithFixpoint {
+	public:
+		/** Number of parameters expected by setParameters (same layout as NormalizeWithFixpoint::getParameters) */
+		static const size_t numParameters = 6;
+		
+		/** Constructor, scales [-1,1] to [-1,1] with the fixpoint 0 until setParameters is called */
+		constexpr StaticNormalizeWithFixpoint() :
+			m_fixpoint(0.0),
+			m_fixpointNorm(0.0),
+			m_slopeBelow(1.0),
+			m_slopeAbove(1.0),
+			m_inverseSlopeBelow(1.0),
+			m_inverseSlopeAbove(1.0)
+		{}
+		/** Constructor
+		 *  \pre minNorm < fixpointNorm < maxNorm
+		 *  \pre seenMin < fixpoint < seenMax
+		 *  \param fixpoint the unscaled fixpoint
+		 *  \param fixpointNorm the scaled fixpoint
+		 *  \param minNorm the minimal double value of a scaled value
+		 *  \param maxNorm the maximal double value of a scaled value
+		 *  \param seenMin the minimal double value of all not scaled values
+		 *  \param seenMax the maximal double value of all not scaled values
+		 */
+		constexpr StaticNormalizeWithFixpoint(double fixpoint, double fixpointNorm, double minNorm, double maxNorm, double seenMin, double seenMax) :
+			m_fixpoint(fixpoint),
+			m_fixpointNorm(fixpointNorm),
+			m_slopeBelow((fixpointNorm-minNorm)/(fixpoint-seenMin)),
+			m_slopeAbove((maxNorm-fixpointNorm)/(seenMax-fixpoint)),
+			m_inverseSlopeBelow((fixpoint-seenMin)/(fixpointNorm-minNorm)),
+			m_inverseSlopeAbove((seenMax-fixpoint)/(maxNorm-fixpointNorm))
+		{}
+		/** Scales a single value */
+		constexpr double scale(double value) const {
+			return m_fixpointNorm + (value-m_fixpoint)*(value < m_fixpoint ? m_slopeBelow : m_slopeAbove);
+		}
+		/** Takes a scaled value and returns the original non scaled value. */
+		constexpr double originalValue(double value) const {
+			return m_fixpoint + (value-m_fixpointNorm)*(value < m_fixpointNorm ? m_inverseSlopeBelow : m_inverseSlopeAbove);
+		}
+		/** Restores the parameters written by NormalizeWithFixpoint::getParameters()
+		 *  \pre params.size() == numParameters
+		 */
+		void setParameters(const std::vector<double>& params) {
+			*this = StaticNormalizeWithFixpoint(params[2], params[3], params[4], params[5], params[0], params[1]);
+		}
+		/** Returns the type name of the matching Scaler (used to validate parameter files) */
+		static const char* typeName() {
+			return "NormalizeWithFixpoint";
+		}
+	private:
+		double m_fixpoint;
+		double m_fixpointNorm;
+		double m_slopeBelow;
+		double m_slopeAbove;
+		double m_inverseSlopeBelow;
+		double m_inverseSlopeAbove;
+	};
+	
+	/** Describes N consecutive dimensions that are all scaled by the static scaler type S (StaticNormalize or StaticNormalizeWithFixpoint). */
+	template<class S, size_t N>
+	struct StaticDimensions {
+		typedef S ScalerType;
+		static const size_t size = N;
+	};
+	
+	/** Unrolls the scaling of the values [Begin, Begin+Count) at compile time.
+	 *  The range is split in halves, so the template recursion depth only grows logarithmic with the number of dimensions.
+	 */
+	template<size_t Begin, size_t Count>
+	struct StaticUnroll {
+		template<class S>
+		static inline void scale(const S* scalers, double* values) {
+			StaticUnroll<Begin, Count/2>::scale(scalers, values);
+			StaticUnroll<Begin+Count/2, Count-Count/2>::scale(scalers, values);
+		}
+		template<class S>
+		static inline void originalValues(const S* scalers, double* values) {
+			StaticUnroll<Begin, Count/2>::originalValues(scalers, values);
+			StaticUnroll<Begin+Count/2, Count-Count/2>::originalValues(scalers, values);
+		}
+	};
+	template<size_t Begin>
+	struct StaticUnroll<Begin, 1> {
+		template<class S>
+		static inline void scale(const S* scalers, double* values) {
+			values[Begin] = scalers[Begin].scale(values[Begin]);
+		}
+		template<class S>
+		static inline void originalValues(const S* scalers, double* values) {
+			values[Begin] = scalers[Begin].originalValue(values[Begin]);
+		}
+	};
+	template<size_t Begin>
+	struct StaticUnroll<Begin, 0> {
+		template<class S>
+		static inline void scale(const S*, double*) {}
+		template<class S>
+		static inline void originalValues(const S*, double*) {}
+	};
+	
+	/** A fixed sequence of StaticDimensions, e.g.
+	 *  StaticScalerLayout<StaticDimensions<StaticNormalizeWithFixpoint, 4>, StaticDimensions<StaticNormalize, 8> >
+	 *  describes 12 dimensions where the first 4 are scaled with a fixpoint.
+	 */
+	template<class... Segments>
+	class StaticScalerLayout;
+	
+	template<>
+	class StaticScalerLayout<> {
+	public:
+		static const size_t size = 0;
+		inline void scale(double*) const {}
+		inline void originalValues(double*) const {}
+		void load(ScalerFactory&, const std::string&, size_t) {}
+	};
+	
+	template<class Segment, class... Rest>
+	class StaticScalerLayout<Segment, Rest...> {
+	public:
+		typedef typename Segment::ScalerType ScalerType;
+		static_assert(Segment::size > 0, "StaticDimensions must contain at least one dimension");
+		
+		/** Total number of dimensions of the layout */
+		static const size_t size = Segment::size + StaticScalerLayout<Rest...>::size;
+		
+		/** Scales the values [0, size) in place */
+		inline void scale(double* values) const {
+			StaticUnroll<0, Segment::size>::scale(m_scalers, values);
+			m_rest.scale(values + Segment::size);
+		}
+		/** Restores the original values [0, size) in place */
+		inline void originalValues(double* values) const {
+			StaticUnroll<0, Segment::size>::originalValues(m_scalers, values);
+			m_rest.originalValues(values + Segment::size);
+		}
+		/** Loads the parameters of the scalers prefix<first> ... prefix<first+size-1>
+		 *  \param factory the factory of the parameter file
+		 *  \param prefix "input" or "target"
+		 *  \param first the id number of the first scaler of the layout
+		 */
+		void load(ScalerFactory& factory, const std::string& prefix, size_t first) throw (FileOpenException, ParseException) {
+			for (size_t i = 0; i < Segment::size; i++) {
+				std::stringstream sstr;
+				sstr<<prefix<<(first+i);
+				Scaler* s = factory.getScaler(sstr.str());
+				if (s->getTypeName().compare(ScalerType::typeName()) != 0) {
+					std::string type = s->getTypeName();
+					delete s;
+					throw ParseException("scaler " + sstr.str() + " has the type " + type + " instead of " + ScalerType::typeName());
+				}
+				std::vector<double> params;
+				s->getParameters(params);
+				delete s;
+				m_scalers[i].setParameters(params);
+			}
+			m_rest.load(factory, prefix, first + Segment::size);
+		}
+	private:
+		ScalerType m_scalers[Segment::size];
+		StaticScalerLayout<Rest...> m_rest;
+	};
+	
+	/** \brief A PatternScaler with a layout that is known at compile time.
+	 *  Instead of calling a virtual method per dimension, the scaling of a pattern is unrolled and inlined. The parameters are loaded from the same files as PatternScaler::loadFromFile reads.
+	 *  Example for 12 inputs where the first 4 are scaled with a fixpoint and a single target:
+	 *  \code
+	 *  typedef StaticPatternScaler<
+	 *      StaticScalerLayout<StaticDimensions<StaticNormalizeWithFixpoint, 4>, StaticDimensions<StaticNormalize, 8> >,
+	 *      StaticScalerLayout<StaticDimensions<StaticNormalize, 1> > > MyScaler;
+	 *  \endcode
+	 */
+	template<class InputLayout, class TargetLayout>
+	class StaticPatternScaler {
+	public:
+#ifdef __APPLE__
+#pragma mark Construction and loading
+#endif
+		/** \name Construction and loading
+		 @{ */
+		
+		/** Default constructor - all scalers use their default parameters until loadFromFile is called */
+		StaticPatternScaler() {}
+		/** Loads the parameters from a file written by PatternScaler::saveToFile
+		 *  \param filename
+		 */
+		explicit StaticPatternScaler(const std::string& filename) throw (FileOpenException, ParseException) {
+			loadFromFile(filename);
+		}
+		/** Loads the parameters from a file written by PatternScaler::saveToFile.
+		 *  The number and types of the scalers in the file have to match the layouts, otherwise a ParseException is thrown.
+		 *  \param filename
+		 */
+		void loadFromFile(const std::string& filename) throw (FileOpenException, ParseException) {
+			ScalerFactory factory(filename);
+			if (factory.getMaxId("input") != InputLayout::size) {
+				throw ParseException("number of input scalers in " + filename + " does not match the static layout");
+			}
+			if (factory.getMaxId("target") != TargetLayout::size) {
+				throw ParseException("number of target scalers in " + filename + " does not match the static layout");
+			}
+			m_inputs.load(factory, "input", 1);
+			m_targets.load(factory, "target", 1);
+		}
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Scaling of data
+#endif
+		/** \name Scaling of data
+		 @{ */
+		
+		/** Scales the values with the input scalers.
+		 *  \param values unscaled double values (numInputDimensions() entries)
+		 */
+		inline void scaleInput(double* values) const {
+			m_inputs.scale(values);
+		}
+		/** Scales the values with the target scalers.
+		 *  \param values unscaled double values (numTargetDimensions() entries)
+		 */
+		inline void scaleTarget(double* values) const {
+			m_targets.scale(values);
+		}
+		/** Scales the input values of all patterns
+		 *  \pre patternSet.input_count == numInputDimensions()
+		 *  \param patternSet an PatternSet with not scaled input values
+		 */
+		void scaleInputs(NPP2::PatternSet& patternSet) const {
+			for (size_t i = 0; i < patternSet.pattern_count; i++) {
+				m_inputs.scale(patternSet.input[i]);
+			}
+		}
+		/** Scales the target values of all patterns
+		 *  \pre patternSet.target_count == numTargetDimensions()
+		 *  \param patternSet an PatternSet with not scaled target values
+		 */
+		void scaleTargets(NPP2::PatternSet& patternSet) const {
+			for (size_t i = 0; i < patternSet.pattern_count; i++) {
+				m_targets.scale(patternSet.target[i]);
+			}
+		}
+		/** Scales the input and target values of all patterns
+		 *  \param patternSet an PatternSet with not scaled input and target values
+		 */
+		void scale(NPP2::PatternSet& patternSet) const {
+			scaleInputs(patternSet);
+			scaleTargets(patternSet);
+		}
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Restoring the original values from scaled values
+#endif
+		/** \name Restoring the original values from scaled values
+		 @{ */
+		
+		/** Takes scaled values and return them to their original not scaled values
+		 *  \param values scaled values (numTargetDimensions() entries)
+		 */
+		inline void originalTargetValues(double* values) const {
+			m_targets.originalValues(values);
+		}
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Dimension informations
+#endif
+		/** \name Dimension informations
+		 @{ */
+		
+		/** Returns the number of input scalers */
+		static constexpr size_t numInputDimensions() {
+			return InputLayout::size;
+		}
+		/** Returns the number of target scalers */
+		static constexpr size_t numTargetDimensions() {
+			return TargetLayout::size;
+		}
+		
+		/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#endif
+		
+	private:
+		InputLayout m_inputs;
+		TargetLayout m_targets;
+	};
+}
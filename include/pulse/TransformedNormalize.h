@@ -0,0 +1,137 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+
+namespace pulse {
+	/**
+	 * \brief Transforms for TransformedNormalize.
+	 * apply() is the exact transform (libm), applyFast() a polynomial approximation without branches or library calls, the batch version of it is vectorized by the compiler. invert() is the exact inverse.
+	 * getRange() maps the fitted range [min,max] of the unscaled values to the linear map inScale*x+inOffset that is applied before the transform and the range [low,high] of the transformed values.
+	 */
+	struct Log1pTransform {
+		/** log(1+x), the values have to be > -1 */
+		static double apply(double x);
+		/** absolute error below 1.8e-15 for x up to 1e6 (measured), the relative error grows near 0 where the result is small */
+		static double applyFast(double x);
+		/** applyFast() for values[i] with \f$i \in {0...num-1}\f$ in place */
+		static void applyFast(double* values, size_t num);
+		static double invert(double y);
+		static void getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high);
+		static const char* name();
+	};
+	struct SignedLogTransform {
+		/** sign(x)*log(1+|x|) */
+		static double apply(double x);
+		/** absolute error below 3.6e-15 for |x| up to 1e9 (measured), the relative error grows near 0 where the result is small */
+		static double applyFast(double x);
+		/** applyFast() for values[i] with \f$i \in {0...num-1}\f$ in place */
+		static void applyFast(double* values, size_t num);
+		static double invert(double y);
+		static void getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high);
+		static const char* name();
+	};
+	struct TanhTransform {
+		/** tanh(x), the fitted range is mapped to [-1,1] before, so the seen values use the inner 76% of the norm range and unseen values are squashed into it */
+		static double apply(double x);
+		/** absolute error below 2.3e-16 (1 ulp of 1) */
+		static double applyFast(double x);
+		/** applyFast() for values[i] with \f$i \in {0...num-1}\f$ in place */
+		static void applyFast(double* values, size_t num);
+		static double invert(double y);
+		static void getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high);
+		static const char* name();
+	};
+	
+	/**
+	 * \brief The class TransformedNormalize applies a nonlinear Transform and scales the transformed values to [minNorm, maxNorm] in one pass, e.g. for skewed features that would otherwise be transformed by hand before scaling.
+	 * The range is fitted on the unscaled values like Normalize. originalValue() uses the exact inverse of the transform.
+	 * By default the batch and single value scaling use the fast approximation of the transform, with exact = true the libm functions are used.
+	 */
+	template<class Transform>
+	class TransformedNormalize : public Scaler {
+	public:
+		/** Constructor
+		 *  \pre minNorm < maxNorm
+		 *  \param minNorm
+		 *  \param maxNorm
+		 *  \param exact use the exact transform instead of the fast approximation
+		 */
+		TransformedNormalize(double minNorm, double maxNorm, bool exact = false);
+		virtual ~TransformedNormalize() {}
+		virtual void updateScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void updateScalingFactors(double value);
+		virtual void resetScalingFactors(double const* data, size_t offset, size_t num);
+		virtual void resetScalingFactors(double** const data, size_t offset, size_t num);
+		virtual void scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const;
+		virtual void scale(double** data, size_t offset, size_t num) const;
+		virtual double scale(double value) const;
+		virtual double originalValue(double value) const;
+		/** The parameters are min, max, minNorm, maxNorm and exact */
+		virtual void getParameters(std::vector<double>& params) const;
+		virtual void setParameters(const std::vector<double>& params);
+		virtual const std::string& getTypeName() const;
+		virtual Scaler* clone() const;
+		/** \throw MergeException if other has another type, norm range or precision (exact) */
+		virtual void merge(const Scaler& other);
+		virtual bool isExtremaSufficient() const;
+		virtual bool getNormRange(double& minNorm, double& maxNorm) const;
+		bool isExact() const;
+		void setExact(bool exact);
+	private:
+		/** Makes sure that m_min < m_max and updates the coefficients */
+		void updateRange();
+		template<class Input, class Output>
+		void transform(const Input& in, const Output& out, size_t num) const;
+		
+		double m_min;
+		double m_max;
+		double m_minNorm;
+		double m_maxNorm;
+		bool m_exact;
+		/** scaled value = (transform(value*m_inScale + m_inOffset) - m_low)*m_factor + m_minNorm */
+		double m_inScale;
+		double m_inOffset;
+		double m_low;
+		double m_factor;
+		static std::string m_name;
+	};
+	
+	typedef TransformedNormalize<Log1pTransform> Log1pNormalize;
+	typedef TransformedNormalize<SignedLogTransform> SignedLogNormalize;
+	typedef TransformedNormalize<TanhTransform> TanhNormalize;
+}
@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <cassert>
+#include <pulse/Instrumentation.h>
 
 namespace pulse {
 
@@ -68,7 +69,9 @@ namespace pulse {
 			if (curr != '\n' && curr != m_seperator && m_fstream.good()) {
 				s<<curr;
 			} else {
-				re.push_back(atof(s.str().c_str()));
+				std::string field = s.str();
+				re.push_back(atof(field.c_str()));
+				PULSE_COUNT(BytesParsed, field.size()+1);
 				s.str(std::string());
 				if (curr == '\n' || !m_fstream.good()) {
 					done = true;
@@ -95,7 +98,9 @@ namespace pulse {
 			}
 			m_char++;
 		}
-		return s.str();
+		std::string re = s.str();
+		PULSE_COUNT(BytesParsed, re.size()+1);
+		return re;
 	}
 	
 	void CSVReader::readEntries(size_t num, std::vector<std::string>& re) throw (ParseException) {
@@ -104,6 +109,9 @@ namespace pulse {
 		}
 		assert(num > 0);
 		
+#ifdef PULSE_INSTRUMENTATION
+		const size_t first = re.size();
+#endif
 		for (size_t i = 0; i < num; i++) {
 			bool done = false;
 			std::stringstream s;
@@ -124,6 +132,15 @@ namespace pulse {
 				}
 			}
 		}
+#ifdef PULSE_INSTRUMENTATION
+		if (Instrumentation::isEnabled()) {
+			size_t bytes = 0;
+			for (size_t i = first; i < re.size(); i++) {
+				bytes += re[i].size()+1;
+			}
+			Instrumentation::count(Instrumentation::BytesParsed, bytes);
+		}
+#endif
 	}
 	void CSVReader::readEntries(size_t num, std::vector<double>& re) throw (ParseException) {
 		assert(num > 0);
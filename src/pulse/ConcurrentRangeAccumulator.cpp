@@ -0,0 +1,127 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/ConcurrentRangeAccumulator.h>
+
+#include <cassert>
+#include <limits>
+
+namespace pulse {
+	namespace {
+		/** number of doubles in a cache line */
+		const size_t cacheLineValues = 64/sizeof(double);
+		
+		inline void atomicMin(std::atomic<double>& min, double value) {
+			double current = min.load(std::memory_order_relaxed);
+			while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+			}
+		}
+		inline void atomicMax(std::atomic<double>& max, double value) {
+			double current = max.load(std::memory_order_relaxed);
+			while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+			}
+		}
+		
+		/** Source of the thread numbers of getThreadShard() */
+		std::atomic<size_t> s_nextThread(0);
+	}
+	
+	ConcurrentRangeAccumulator::ConcurrentRangeAccumulator(size_t numDimensions, size_t numShards) :
+		m_numDimensions(numDimensions),
+		m_numShards(numShards),
+		m_stride((2*numDimensions + cacheLineValues - 1)/cacheLineValues*cacheLineValues + cacheLineValues),
+		m_extrema(m_stride*numShards)
+	{
+		assert(numDimensions > 0);
+		assert(numShards > 0);
+		clear();
+	}
+	void ConcurrentRangeAccumulator::update(size_t shard, size_t dimension, double value) {
+		assert(shard < m_numShards);
+		assert(dimension < m_numDimensions);
+		std::atomic<double>* extrema = &m_extrema[shard*m_stride];
+		atomicMin(extrema[dimension], value);
+		atomicMax(extrema[m_numDimensions + dimension], value);
+	}
+	void ConcurrentRangeAccumulator::update(size_t shard, const double* values, size_t start, size_t num) {
+		assert(shard < m_numShards);
+		assert(start + num <= m_numDimensions);
+		std::atomic<double>* min = &m_extrema[shard*m_stride + start];
+		std::atomic<double>* max = min + m_numDimensions;
+		for (size_t i = 0; i < num; i++) {
+			atomicMin(min[i], values[i]);
+			atomicMax(max[i], values[i]);
+		}
+	}
+	void ConcurrentRangeAccumulator::update(const std::vector<double>& values, size_t start) {
+		if (!values.empty()) {
+			update(getThreadShard(), &values[0], start, values.size());
+		}
+	}
+	void ConcurrentRangeAccumulator::getExtrema(size_t dimension, double& min, double& max) const {
+		assert(dimension < m_numDimensions);
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		for (size_t shard = 0; shard < m_numShards; shard++) {
+			const std::atomic<double>* extrema = &m_extrema[shard*m_stride];
+			const double shardMin = extrema[dimension].load(std::memory_order_relaxed);
+			const double shardMax = extrema[m_numDimensions + dimension].load(std::memory_order_relaxed);
+			if (shardMin < min) {
+				min = shardMin;
+			}
+			if (shardMax > max) {
+				max = shardMax;
+			}
+		}
+	}
+	void ConcurrentRangeAccumulator::clear() {
+		for (size_t shard = 0; shard < m_numShards; shard++) {
+			std::atomic<double>* extrema = &m_extrema[shard*m_stride];
+			for (size_t i = 0; i < m_numDimensions; i++) {
+				extrema[i].store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+				extrema[m_numDimensions + i].store(-std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+			}
+		}
+	}
+	size_t ConcurrentRangeAccumulator::getThreadShard() const {
+		static thread_local size_t thread = s_nextThread.fetch_add(1, std::memory_order_relaxed);
+		return thread % m_numShards;
+	}
+	size_t ConcurrentRangeAccumulator::numDimensions() const {
+		return m_numDimensions;
+	}
+	size_t ConcurrentRangeAccumulator::numShards() const {
+		return m_numShards;
+	}
+}
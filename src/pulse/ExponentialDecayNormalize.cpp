@@ -0,0 +1,275 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/ExponentialDecayNormalize.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace pulse {
+	namespace {
+		using detail::StridedAccessor;
+		using detail::RowAccessor;
+		
+		const size_t numLanes = 4;
+	}
+	
+	std::string ExponentialDecayNormalize::m_name = std::string("ExponentialDecayNormalize");
+	
+	ExponentialDecayNormalize::ExponentialDecayNormalize(double minNorm, double maxNorm, double halfLife, double numDeviations) :
+		m_mean(0.0),
+		m_variance(0.0),
+		m_weight(0.0),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm),
+		m_halfLife(halfLife),
+		m_numDeviations(numDeviations),
+		m_decay(pow(2.0, -1.0/halfLife))
+	{
+		assert(minNorm < maxNorm);
+		assert(halfLife > 0.0);
+		assert(numDeviations > 0.0);
+		updateCoefficients();
+	}
+	void ExponentialDecayNormalize::addBlock(size_t num, double center, double sum, double sumOfSquares) {
+		//closed form of num single updates: every old weight is multiplied with decay^num
+		const double oldFactor = pow(m_decay, static_cast<double>(num));
+		const double blockWeight = (m_decay < 1.0) ? (1.0 - oldFactor)/(1.0 - m_decay) : static_cast<double>(num);
+		const double oldDelta = m_mean - center;
+		const double weight = oldFactor*m_weight + blockWeight;
+		//weighted first and second moment around center
+		const double s1 = oldFactor*m_weight*oldDelta + sum;
+		const double s2 = oldFactor*m_weight*(m_variance + oldDelta*oldDelta) + sumOfSquares;
+		const double meanDelta = s1/weight;
+		m_weight = weight;
+		m_mean = center + meanDelta;
+		m_variance = s2/weight - meanDelta*meanDelta;
+		if (m_variance < 0.0) {
+			//rounding
+			m_variance = 0.0;
+		}
+	}
+	template<class Accessor>
+	void ExponentialDecayNormalize::update(const Accessor& data, size_t num) {
+		bool hasNaN = false;
+		for (size_t i = 0; i < num; i++) {
+			const double value = data(i);
+			hasNaN |= (value != value);
+		}
+		if (!hasNaN) {
+			updateBlock(data, num);
+			return;
+		}
+		//like updateScalingFactors(double) NaN does not count as a step of the decay, so the other values are summed as one block
+		std::vector<double> values;
+		values.reserve(num);
+		for (size_t i = 0; i < num; i++) {
+			const double value = data(i);
+			if (value == value) {
+				values.push_back(value);
+			}
+		}
+		if (!values.empty()) {
+			updateBlock(StridedAccessor(&values[0], 1), values.size());
+		}
+	}
+	template<class Accessor>
+	void ExponentialDecayNormalize::updateBlock(const Accessor& data, size_t num) {
+		//summing relative to the current mean (or the first value) avoids cancellation
+		const double center = (m_weight > 0.0) ? m_mean : data(0);
+		const size_t numGroups = num/numLanes;
+		const double groupDecay = pow(m_decay, static_cast<double>(numLanes));
+		//lane j sums the values numLanes*g+j, each lane decays by decay^numLanes per group
+		double sum[numLanes] = {0.0, 0.0, 0.0, 0.0};
+		double sumOfSquares[numLanes] = {0.0, 0.0, 0.0, 0.0};
+		for (size_t g = 0; g < numGroups; g++) {
+			for (size_t j = 0; j < numLanes; j++) {
+				const double d = data(g*numLanes + j) - center;
+				sum[j] = sum[j]*groupDecay + d;
+				sumOfSquares[j] = sumOfSquares[j]*groupDecay + d*d;
+			}
+		}
+		//combine the lanes: value numLanes*g+j is followed by numLanes-1-j values of its group
+		double blockSum = 0.0;
+		double blockSumOfSquares = 0.0;
+		double laneFactor = 1.0;
+		for (size_t j = numLanes; j > 0; j--) {
+			blockSum += laneFactor*sum[j-1];
+			blockSumOfSquares += laneFactor*sumOfSquares[j-1];
+			laneFactor *= m_decay;
+		}
+		//the remaining values
+		for (size_t i = numGroups*numLanes; i < num; i++) {
+			const double d = data(i) - center;
+			blockSum = blockSum*m_decay + d;
+			blockSumOfSquares = blockSumOfSquares*m_decay + d*d;
+		}
+		addBlock(num, center, blockSum, blockSumOfSquares);
+		updateCoefficients();
+	}
+	void ExponentialDecayNormalize::updateCoefficients() {
+		double spread = m_numDeviations*sqrt(m_variance);
+		if (!(spread > 0.0)) {
+			//no deviation seen so far, make sure that the scaling stays defined
+			spread = 1.0;
+		}
+		m_lower = m_mean - spread;
+		m_slope = (m_maxNorm-m_minNorm)/(2.0*spread);
+	}
+	void ExponentialDecayNormalize::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		update(StridedAccessor(data, offset), num);
+	}
+	void ExponentialDecayNormalize::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		if (num > 0) {
+			update(RowAccessor(data, offset), num);
+		}
+	}
+	void ExponentialDecayNormalize::updateScalingFactors(double value) {
+		if (value != value) {
+			return;
+		}
+		const double center = (m_weight > 0.0) ? m_mean : value;
+		const double d = value - center;
+		addBlock(1, center, d, d*d);
+		updateCoefficients();
+	}
+	void ExponentialDecayNormalize::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		if (value != value) {
+			return;
+		}
+		const double center = (m_weight > 0.0) ? m_mean : value;
+		const double d = value - center;
+		//the decayed weights of the copies sum up like in addBlock()
+		const double n = static_cast<double>(num);
+		const double weight = (m_decay < 1.0) ? (1.0 - pow(m_decay, n))/(1.0 - m_decay) : n;
+		addBlock(num, center, weight*d, weight*d*d);
+		updateCoefficients();
+	}
+	void ExponentialDecayNormalize::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_weight = 0.0;
+		m_mean = 0.0;
+		m_variance = 0.0;
+		updateScalingFactors(data, offset, num);
+	}
+	void ExponentialDecayNormalize::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_weight = 0.0;
+		m_mean = 0.0;
+		m_variance = 0.0;
+		updateScalingFactors(data, offset, num);
+	}
+	void ExponentialDecayNormalize::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		for (size_t i = 0; i < num; i++) {
+			out[i*outOffset] = (in[i*inOffset]-m_lower)*m_slope + m_minNorm;
+		}
+	}
+	void ExponentialDecayNormalize::scale(double** data, size_t offset, size_t num) const {
+		for (size_t i = 0; i < num; i++) {
+			data[i][offset] = (data[i][offset]-m_lower)*m_slope + m_minNorm;
+		}
+	}
+	double ExponentialDecayNormalize::scale(double value) const {
+		return (value-m_lower)*m_slope + m_minNorm;
+	}
+	double ExponentialDecayNormalize::originalValue(double value) const {
+		return (value-m_minNorm)/m_slope + m_lower;
+	}
+	bool ExponentialDecayNormalize::getPiecewiseLinear(PiecewiseLinear& function) const {
+		function = PiecewiseLinear(m_lower, m_minNorm, m_slope, m_slope);
+		return true;
+	}
+	bool ExponentialDecayNormalize::getNormRange(double& minNorm, double& maxNorm) const {
+		minNorm = m_minNorm;
+		maxNorm = m_maxNorm;
+		return true;
+	}
+	void ExponentialDecayNormalize::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_mean);
+		params.push_back(m_variance);
+		params.push_back(m_weight);
+		params.push_back(m_minNorm);
+		params.push_back(m_maxNorm);
+		params.push_back(m_halfLife);
+		params.push_back(m_numDeviations);
+	}
+	void ExponentialDecayNormalize::setParameters(const std::vector<double>& params) {
+		assert(params.size() == 7);
+		assert(params[5] > 0.0);
+		m_mean = params[0];
+		m_variance = params[1];
+		m_weight = params[2];
+		m_minNorm = params[3];
+		m_maxNorm = params[4];
+		m_halfLife = params[5];
+		m_numDeviations = params[6];
+		m_decay = pow(2.0, -1.0/m_halfLife);
+		updateCoefficients();
+	}
+	const std::string& ExponentialDecayNormalize::getTypeName() const {
+		return m_name;
+	}
+	Scaler* ExponentialDecayNormalize::clone() const {
+		return new ExponentialDecayNormalize(*this);
+	}
+	void ExponentialDecayNormalize::merge(const Scaler& other) {
+		checkMergeable(other);
+		const ExponentialDecayNormalize& o = static_cast<const ExponentialDecayNormalize&>(other);
+		if (o.m_halfLife != m_halfLife || o.m_numDeviations != m_numDeviations) {
+			throw MergeException("ExponentialDecayNormalize scalers with different half-lives or numbers of deviations can not be merged");
+		}
+		const double weight = m_weight + o.m_weight;
+		if (weight == 0.0) {
+			return;
+		}
+		//weighted moments around the combined mean
+		const double mean = (m_weight*m_mean + o.m_weight*o.m_mean)/weight;
+		const double delta = m_mean - mean;
+		const double otherDelta = o.m_mean - mean;
+		m_variance = (m_weight*(m_variance + delta*delta) + o.m_weight*(o.m_variance + otherDelta*otherDelta))/weight;
+		m_mean = mean;
+		m_weight = weight;
+		updateCoefficients();
+	}
+	double ExponentialDecayNormalize::getMean() const {
+		return m_mean;
+	}
+	double ExponentialDecayNormalize::getVariance() const {
+		return m_variance;
+	}
+}
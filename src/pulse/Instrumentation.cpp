@@ -0,0 +1,146 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Instrumentation.h>
+
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+
+namespace pulse {
+	namespace {
+		/** a counter on its own cache line, so counters updated by different threads do not share lines */
+		struct PaddedCounter {
+			std::atomic<unsigned long> value;
+			char padding[64 - sizeof(std::atomic<unsigned long>)];
+		};
+		
+		PaddedCounter g_counters[Instrumentation::NumCounters];
+		PaddedCounter g_timers[Instrumentation::NumTimers];
+		
+		const char* counterNames[Instrumentation::NumCounters] = {
+			"pulse_values_scaled_total",
+			"pulse_values_fitted_total",
+			"pulse_values_restored_total",
+			"pulse_bytes_parsed_total",
+			"pulse_files_loaded_total",
+			"pulse_files_saved_total"
+		};
+		const char* counterHelp[Instrumentation::NumCounters] = {
+			"Values scaled by PatternScaler.",
+			"Values used to update or reset the scalers of a PatternScaler.",
+			"Values returned to their original values by PatternScaler.",
+			"Bytes read by CSVReader.",
+			"Files loaded by PatternScaler::loadFromFile.",
+			"Files written by PatternScaler::saveToFile."
+		};
+		const char* timerNames[Instrumentation::NumTimers] = {
+			"scale",
+			"fit",
+			"restore",
+			"parse",
+			"load",
+			"save"
+		};
+	}
+	
+	std::atomic<bool> Instrumentation::s_enabled(false);
+	
+	void Instrumentation::setEnabled(bool enabled) {
+		s_enabled.store(enabled, std::memory_order_relaxed);
+	}
+	void Instrumentation::count(Counter counter, unsigned long n) {
+		g_counters[counter].value.fetch_add(n, std::memory_order_relaxed);
+	}
+	void Instrumentation::addTime(Timer timer, unsigned long nanoseconds) {
+		g_timers[timer].value.fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+	unsigned long Instrumentation::now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	void Instrumentation::reset() {
+		for (size_t i = 0; i < NumCounters; i++) {
+			g_counters[i].value.store(0, std::memory_order_relaxed);
+		}
+		for (size_t i = 0; i < NumTimers; i++) {
+			g_timers[i].value.store(0, std::memory_order_relaxed);
+		}
+	}
+	InstrumentationSnapshot Instrumentation::snapshot() {
+		InstrumentationSnapshot re;
+		re.valuesScaled = g_counters[ValuesScaled].value.load(std::memory_order_relaxed);
+		re.valuesFitted = g_counters[ValuesFitted].value.load(std::memory_order_relaxed);
+		re.valuesRestored = g_counters[ValuesRestored].value.load(std::memory_order_relaxed);
+		re.bytesParsed = g_counters[BytesParsed].value.load(std::memory_order_relaxed);
+		re.filesLoaded = g_counters[FilesLoaded].value.load(std::memory_order_relaxed);
+		re.filesSaved = g_counters[FilesSaved].value.load(std::memory_order_relaxed);
+		re.scaleNanoseconds = g_timers[ScaleTime].value.load(std::memory_order_relaxed);
+		re.fitNanoseconds = g_timers[FitTime].value.load(std::memory_order_relaxed);
+		re.restoreNanoseconds = g_timers[RestoreTime].value.load(std::memory_order_relaxed);
+		re.parseNanoseconds = g_timers[ParseTime].value.load(std::memory_order_relaxed);
+		re.loadNanoseconds = g_timers[LoadTime].value.load(std::memory_order_relaxed);
+		re.saveNanoseconds = g_timers[SaveTime].value.load(std::memory_order_relaxed);
+		return re;
+	}
+	void Instrumentation::writePrometheus(std::ostream& out) {
+		for (size_t i = 0; i < NumCounters; i++) {
+			out<<"# HELP "<<counterNames[i]<<" "<<counterHelp[i]<<"\n";
+			out<<"# TYPE "<<counterNames[i]<<" counter\n";
+			out<<counterNames[i]<<" "<<g_counters[i].value.load(std::memory_order_relaxed)<<"\n";
+		}
+		out<<"# HELP pulse_operation_seconds_total Cumulative time spent per operation.\n";
+		out<<"# TYPE pulse_operation_seconds_total counter\n";
+		for (size_t i = 0; i < NumTimers; i++) {
+			double seconds = static_cast<double>(g_timers[i].value.load(std::memory_order_relaxed))*1e-9;
+			out<<"pulse_operation_seconds_total{operation=\""<<timerNames[i]<<"\"} "<<seconds<<"\n";
+		}
+	}
+	void Instrumentation::writePrometheus(const std::string& filename) throw (FileOpenException) {
+		std::string tmpName = filename + ".tmp";
+		{
+			std::ofstream out(tmpName.c_str(), std::ios_base::out | std::fstream::trunc);
+			if (!out.good()) {
+				throw FileOpenException(tmpName);
+			}
+			out.precision(17);
+			writePrometheus(out);
+			if (!out.good()) {
+				throw FileOpenException(tmpName);
+			}
+		}
+		if (rename(tmpName.c_str(), filename.c_str()) != 0) {
+			throw FileOpenException(filename);
+		}
+	}
+}
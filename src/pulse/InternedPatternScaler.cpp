@@ -0,0 +1,192 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <pulse/InternedPatternScaler.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+#include <pulse/Instrumentation.h>
+
+namespace pulse {
+	namespace {
+		using detail::imputeMissing;
+		using detail::selectBySign;
+		
+		/** Applies one function to num values, the parameters are broadcast so the loop is vectorized */
+		void broadcastFunction(double* values, size_t num, double pivot, double pivotValue, double slopeBelow, double slopeAbove) {
+			for (size_t i = 0; i < num; i++) {
+				const double d = values[i] - pivot;
+				values[i] = pivotValue + d*selectBySign(d, slopeBelow, slopeAbove);
+			}
+		}
+		/** broadcastFunction() that replaces the results of missing values by imputed */
+		void broadcastFunctionImputing(double* values, size_t num, double pivot, double pivotValue, double slopeBelow, double slopeAbove, double imputed) {
+			for (size_t i = 0; i < num; i++) {
+				const double d = values[i] - pivot;
+				values[i] = imputeMissing(values[i], pivotValue + d*selectBySign(d, slopeBelow, slopeAbove), imputed);
+			}
+		}
+	}
+	
+	const uint32_t InternedPatternScaler::noFunction;
+	
+	InternedPatternScaler::InternedPatternScaler(const PatternScaler& patternScaler, ScalingTable& table, size_t minRunLength) :
+		m_table(table),
+		m_minRunLength(minRunLength),
+		m_impute(false),
+		m_imputedValue(0.0)
+	{
+		m_impute = (patternScaler.getMissingValuePolicy(m_imputedValue) == ImputeMissing);
+		for (size_t i = 0; i < patternScaler.numInputDimensions(); i++) {
+			addDimension(m_inputs, patternScaler.getInputScaler(i), table, false);
+		}
+		//the targets only need to be restored, so the inverse functions are interned
+		for (size_t i = 0; i < patternScaler.numTargetDimensions(); i++) {
+			addDimension(m_targets, patternScaler.getTargetScaler(i), table, true);
+		}
+		buildRuns(m_inputs);
+		buildRuns(m_targets);
+	}
+	InternedPatternScaler::~InternedPatternScaler() {
+		std::vector<Scaler*>::iterator it;
+		for (it = m_inputs.fallbackScalers.begin(); it != m_inputs.fallbackScalers.end(); it++) {
+			delete *it;
+		}
+		for (it = m_targets.fallbackScalers.begin(); it != m_targets.fallbackScalers.end(); it++) {
+			delete *it;
+		}
+	}
+	void InternedPatternScaler::addDimension(Dimensions& dimensions, const Scaler& scaler, ScalingTable& table, bool inverse) {
+		PiecewiseLinear function;
+		if (scaler.getPiecewiseLinear(function)) {
+			dimensions.index.push_back(table.intern(inverse ? function.inverse() : function));
+		} else {
+			dimensions.fallback.push_back(dimensions.index.size());
+			dimensions.index.push_back(noFunction);
+			dimensions.fallbackScalers.push_back(scaler.clone());
+		}
+	}
+	void InternedPatternScaler::buildRuns(Dimensions& dimensions) const {
+		const std::vector<uint32_t>& index = dimensions.index;
+		size_t i = 0;
+		while (i < index.size()) {
+			size_t end = i + 1;
+			while (end < index.size() && index[end] == index[i]) {
+				end++;
+			}
+			Run run;
+			run.begin = i;
+			run.end = end;
+			run.broadcast = (index[i] != noFunction && end - i >= m_minRunLength);
+			if (!run.broadcast && !dimensions.runs.empty() && !dimensions.runs.back().broadcast) {
+				//short runs are merged into one lookup run
+				dimensions.runs.back().end = end;
+			} else {
+				dimensions.runs.push_back(run);
+			}
+			i = end;
+		}
+	}
+	void InternedPatternScaler::apply(const Dimensions& dimensions, double* values, bool inverse) const {
+		//the fallback scalers impute on their own, the restored target values are not imputed
+		const bool impute = m_impute && !inverse;
+		std::vector<Run>::const_iterator it;
+		for (it = dimensions.runs.begin(); it != dimensions.runs.end(); it++) {
+			if (it->broadcast) {
+				const PiecewiseLinear& function = m_table.get(dimensions.index[it->begin]);
+				if (impute) {
+					broadcastFunctionImputing(values + it->begin, it->end - it->begin, function.pivot, function.pivotValue, function.slopeBelow, function.slopeAbove, m_imputedValue);
+				} else {
+					broadcastFunction(values + it->begin, it->end - it->begin, function.pivot, function.pivotValue, function.slopeBelow, function.slopeAbove);
+				}
+			} else {
+				for (size_t i = it->begin; i < it->end; i++) {
+					if (dimensions.index[i] != noFunction) {
+						const double scaled = m_table.get(dimensions.index[i])(values[i]);
+						values[i] = impute ? imputeMissing(values[i], scaled, m_imputedValue) : scaled;
+					}
+				}
+			}
+		}
+		for (size_t i = 0; i < dimensions.fallback.size(); i++) {
+			const size_t dimension = dimensions.fallback[i];
+			if (inverse) {
+				values[dimension] = dimensions.fallbackScalers[i]->originalValue(values[dimension]);
+			} else {
+				values[dimension] = dimensions.fallbackScalers[i]->scale(values[dimension]);
+			}
+		}
+	}
+	
+	void InternedPatternScaler::scaleInput(double* values) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_inputs.index.size());
+		apply(m_inputs, values, false);
+	}
+	void InternedPatternScaler::scaleInputs(NPP2::PatternSet& patternSet) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_inputs.index.size());
+		assert(patternSet.input_count == m_inputs.index.size());
+		for (size_t i = 0; i < patternSet.pattern_count; i++) {
+			apply(m_inputs, patternSet.input[i], false);
+		}
+	}
+	void InternedPatternScaler::originalTargetValues(double* values) const {
+		PULSE_TIME(RestoreTime);
+		PULSE_COUNT(ValuesRestored, m_targets.index.size());
+		apply(m_targets, values, true);
+	}
+	
+	size_t InternedPatternScaler::numInputDimensions() const {
+		return m_inputs.index.size();
+	}
+	size_t InternedPatternScaler::numTargetDimensions() const {
+		return m_targets.index.size();
+	}
+	uint32_t InternedPatternScaler::getInputIndex(size_t dimension) const {
+		assert(dimension < m_inputs.index.size());
+		return m_inputs.index[dimension];
+	}
+	size_t InternedPatternScaler::numInputBroadcasts() const {
+		size_t re = 0;
+		std::vector<Run>::const_iterator it;
+		for (it = m_inputs.runs.begin(); it != m_inputs.runs.end(); it++) {
+			if (it->broadcast) {
+				re++;
+			}
+		}
+		return re;
+	}
+}
@@ -36,18 +36,29 @@
  */
 
 #include <pulse/Normalize.h>
+#include "ScalingHelpers.h"
 
 #include <iostream>
 #include <cassert>
 
 namespace pulse {
+	namespace {
+		using detail::isMissing;
+		using detail::maskMissing;
+		using detail::imputeMissing;
+	}
+	
 	std::string Normalize::m_name = std::string("Normalize");
 	
 	Normalize::Normalize(double minNorm, double maxNorm) :
 		m_min(0.0),
 		m_max(1.0),
 		m_minNorm(minNorm),
-		m_maxNorm(maxNorm)
+		m_maxNorm(maxNorm),
+		m_concurrent(false),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
 	{
 		//pre conditions
 		assert(minNorm < maxNorm);
@@ -60,7 +71,11 @@ namespace pulse {
 		m_min(seenMin),
 		m_max(seenMax),
 		m_minNorm(minNorm),
-		m_maxNorm(maxNorm)
+		m_maxNorm(maxNorm),
+		m_concurrent(false),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
 	{
 		//preconditions
 		assert(minNorm < maxNorm);
@@ -72,48 +87,88 @@ namespace pulse {
 	void Normalize::updateScalingFactors(double const* data, size_t offset, size_t num) {
 		assert(num > 0);
 		//determine min and max
-		for (int i = 1; i < num; i++) {
-			if (m_max < data[i*offset]) {
-				m_max = data[i*offset];
+		if (m_missingPolicy == PropagateMissing) {
+			for (size_t i = 0; i < num; i++) {
+				if (m_max < data[i*offset]) {
+					m_max = data[i*offset];
+				}
+				if (m_min > data[i*offset]) {
+					m_min = data[i*offset];
+				}
 			}
-			if (m_min > data[i*offset]) {
-				m_min = data[i*offset];
+		} else {
+			//missing values are masked to NaN in the same loop, the comparisons skip them
+			size_t missing = 0;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i*offset];
+				missing += isMissing(value);
+				const double masked = maskMissing(value);
+				if (m_max < masked) {
+					m_max = masked;
+				}
+				if (m_min > masked) {
+					m_min = masked;
+				}
 			}
+			m_missingCount += missing;
 		}
-		//make sure that the post condition is met
-		if (m_max - m_min == 0.0) {
-			std::cerr<<"currentMaxQ was == currentMinQ"<<std::endl;
-			m_max = m_max + m_max*m_max  + 1.0;
-		}
+		fixRange();
+		publish();
 
 		//post condition
 		assert(m_min < m_max);
 	}
 	void Normalize::updateScalingFactors(double** const data, size_t offset, size_t num) {
-		for (size_t i = 0; i < num; i++) {
-			if (m_max < data[i][offset]) {
-				m_max = data[i][offset];
+		if (m_missingPolicy == PropagateMissing) {
+			for (size_t i = 0; i < num; i++) {
+				if (m_max < data[i][offset]) {
+					m_max = data[i][offset];
+				}
+				if (m_min > data[i][offset]) {
+					m_min = data[i][offset];
+				}
 			}
-			if (m_min > data[i][offset]) {
-				m_min = data[i][offset];
+		} else {
+			size_t missing = 0;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i][offset];
+				missing += isMissing(value);
+				const double masked = maskMissing(value);
+				if (m_max < masked) {
+					m_max = masked;
+				}
+				if (m_min > masked) {
+					m_min = masked;
+				}
 			}
+			m_missingCount += missing;
 		}
-		//make sure that the post condition is met
-		if (m_max - m_min == 0.0) {
-			std::cerr<<"currentMaxQ was == currentMinQ"<<std::endl;
-			m_max = m_max + m_max*m_max  + 1.0;
-		}
+		fixRange();
+		publish();
 
 		//post condition
 		assert(m_min < m_max);
 	}
 	void Normalize::updateScalingFactors(double value) {
+		if (m_missingPolicy != PropagateMissing && isMissing(value)) {
+			m_missingCount++;
+			return;
+		}
 		if (m_max < value) {
 			m_max = value;
 		}
 		if (m_min > value) {
 			m_min = value;
 		}
+		fixRange();
+		publish();
+	}
+	void Normalize::fixRange() {
+		if (m_missingPolicy != PropagateMissing && m_min > m_max) {
+			//only missing values since the reset
+			m_min = 0.0;
+			m_max = 1.0;
+		}
 		//make sure that the post condition is met
 		if (m_max - m_min == 0.0) {
 			std::cerr<<"currentMaxQ was == currentMinQ"<<std::endl;
@@ -133,16 +188,31 @@ namespace pulse {
 		updateScalingFactors(data, offset, num);
 	}
 	void Normalize::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		const State state = getState();
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			for (size_t i = 0; i < num; i++) {
+				const double value = in[i*inOffset];
+				out[i*outOffset] = imputeMissing(value, scale(value, state), imputed);
+			}
+			return;
+		}
 		for (int i = 0; i < num; i++) {
-			out[i*outOffset] = scale(in[i*inOffset]);
+			out[i*outOffset] = scale(in[i*inOffset], state);
 		}
 	}
 	double Normalize::scale(double value) const {
-		double re = ((value-m_min)/(m_max-m_min))*(m_maxNorm-m_minNorm)+m_minNorm;
-		if (re < m_minNorm) {
-			std::cerr<<"got value that was smaller than the m_minNorm re="<<re<<" m_minNorm="<<m_minNorm<<std::endl;
+		if (m_missingPolicy == ImputeMissing) {
+			return imputeMissing(value, scale(value, getState()), m_imputedValue);
+		}
+		return scale(value, getState());
+	}
+	double Normalize::scale(double value, const State& state) const {
+		double re = ((value-state.min)/(state.max-state.min))*(state.maxNorm-state.minNorm)+state.minNorm;
+		if (re < state.minNorm) {
+			std::cerr<<"got value that was smaller than the m_minNorm re="<<re<<" m_minNorm="<<state.minNorm<<std::endl;
 			return re;
-		} else if (re > m_maxNorm) {
+		} else if (re > state.maxNorm) {
 			std::cerr<<"got value that was bigger than the m_maxNorm"<<std::endl;
 			return re;
 		} else {
@@ -150,19 +220,45 @@ namespace pulse {
 		}
 	}
 	void Normalize::scale(double** data, size_t offset, size_t num) const {
+		const State state = getState();
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i][offset];
+				data[i][offset] = imputeMissing(value, scale(value, state), imputed);
+			}
+			return;
+		}
 		for (size_t i = 0; i < num; i++) {
-			data[i][offset] = scale(data[i][offset]);
+			data[i][offset] = scale(data[i][offset], state);
 		}
 	}
 	double Normalize::originalValue(double value) const {
-		return ((value - m_minNorm)/(m_maxNorm-m_minNorm))*(m_max-m_min) + m_min;
+		const State state = getState();
+		return ((value - state.minNorm)/(state.maxNorm-state.minNorm))*(state.max-state.min) + state.min;
+	}
+	bool Normalize::getPiecewiseLinear(PiecewiseLinear& function) const {
+		const State state = getState();
+		const double slope = (state.maxNorm-state.minNorm)/(state.max-state.min);
+		function = PiecewiseLinear(state.min, state.minNorm, slope, slope);
+		return true;
+	}
+	bool Normalize::isExtremaSufficient() const {
+		return true;
+	}
+	bool Normalize::getNormRange(double& minNorm, double& maxNorm) const {
+		const State state = getState();
+		minNorm = state.minNorm;
+		maxNorm = state.maxNorm;
+		return true;
 	}
 	void Normalize::getParameters(std::vector<double>& params) const {
 		assert(params.empty());
-		params.push_back(m_min);
-		params.push_back(m_max);
-		params.push_back(m_minNorm);
-		params.push_back(m_maxNorm);
+		const State state = getState();
+		params.push_back(state.min);
+		params.push_back(state.max);
+		params.push_back(state.minNorm);
+		params.push_back(state.maxNorm);
 	}
 	void Normalize::setParameters(const std::vector<double>& params) {
 		assert(params.size() == 4);
@@ -170,6 +266,7 @@ namespace pulse {
 		m_max = params[1];
 		m_minNorm = params[2];
 		m_maxNorm = params[3];
+		publish();
 	}
 	
 	const std::string& Normalize::getTypeName() const {
@@ -177,6 +274,63 @@ namespace pulse {
 	}
 	
 	Scaler* Normalize::clone() const {
-		return new Normalize(m_minNorm, m_maxNorm, m_min, m_max);
+		const State state = getState();
+		Normalize* re = new Normalize(state.minNorm, state.maxNorm, state.min, state.max);
+		re->setConcurrent(m_concurrent);
+		re->setMissingValuePolicy(m_missingPolicy, m_imputedValue);
+		re->m_missingCount = m_missingCount;
+		return re;
+	}
+	void Normalize::merge(const Scaler& other) {
+		checkMergeable(other);
+		const Normalize& o = static_cast<const Normalize&>(other);
+		if (m_min > o.m_min) {
+			m_min = o.m_min;
+		}
+		if (m_max < o.m_max) {
+			m_max = o.m_max;
+		}
+		m_missingCount += o.m_missingCount;
+		publish();
+		//post condition
+		assert(m_min < m_max);
+	}
+	bool Normalize::setConcurrent(bool concurrent) {
+		m_concurrent = concurrent;
+		publish();
+		return true;
+	}
+	bool Normalize::setMissingValuePolicy(MissingValuePolicy policy, double imputedValue) {
+		m_missingPolicy = policy;
+		m_imputedValue = imputedValue;
+		return true;
+	}
+	MissingValuePolicy Normalize::getMissingValuePolicy(double& imputedValue) const {
+		imputedValue = m_imputedValue;
+		return m_missingPolicy;
+	}
+	size_t Normalize::getMissingCount() const {
+		return m_missingCount;
+	}
+	Normalize::State Normalize::getState() const {
+		if (m_concurrent) {
+			return m_published.load();
+		}
+		State state;
+		state.min = m_min;
+		state.max = m_max;
+		state.minNorm = m_minNorm;
+		state.maxNorm = m_maxNorm;
+		return state;
+	}
+	void Normalize::publish() {
+		if (m_concurrent) {
+			State state;
+			state.min = m_min;
+			state.max = m_max;
+			state.minNorm = m_minNorm;
+			state.maxNorm = m_maxNorm;
+			m_published.store(state);
+		}
 	}
 }
\ No newline at end of file
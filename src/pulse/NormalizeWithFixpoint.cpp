@@ -36,11 +36,18 @@
  */
 
 #include <pulse/NormalizeWithFixpoint.h>
+#include "ScalingHelpers.h"
 
 #include <cassert>
 #include <iostream>
 
 namespace pulse {
+	namespace {
+		using detail::isMissing;
+		using detail::maskMissing;
+		using detail::imputeMissing;
+	}
+	
 	std::string NormalizeWithFixpoint::m_name = std::string("NormalizeWithFixpoint");
 	
 	NormalizeWithFixpoint::NormalizeWithFixpoint(double fixpoint, double fixpointNorm, double minNorm, double maxNorm) :
@@ -49,7 +56,11 @@ namespace pulse {
 		m_fixpoint(fixpoint),
 		m_fixpointNorm(fixpointNorm),
 		m_minNorm(minNorm),
-		m_maxNorm(maxNorm)
+		m_maxNorm(maxNorm),
+		m_concurrent(false),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
 	{
 		assert(m_minNorm < m_maxNorm);
 		assert(m_min < m_max);
@@ -64,7 +75,11 @@ namespace pulse {
 		m_fixpoint(fixpoint),
 		m_fixpointNorm(fixpointNorm),
 		m_minNorm(minNorm),
-		m_maxNorm(maxNorm)
+		m_maxNorm(maxNorm),
+		m_concurrent(false),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
 	{
 		assert(m_minNorm < m_maxNorm);
 		assert(m_min < m_max);
@@ -75,16 +90,31 @@ namespace pulse {
 	}
 	void NormalizeWithFixpoint::updateScalingFactors(const double* data, size_t offset, size_t num) {
 		assert(num > 0);
-		//determine min and max
-		m_min = m_fixpoint;
-		m_max = m_fixpoint;
-		for (int i = 0; i < num; i++) {
-			if (m_max < data[i*offset]) {
-				m_max = data[i*offset];
+		//extend min and max, the reset methods start them at the fixpoint
+		if (m_missingPolicy == PropagateMissing) {
+			for (int i = 0; i < num; i++) {
+				if (m_max < data[i*offset]) {
+					m_max = data[i*offset];
+				}
+				if (m_min > data[i*offset]) {
+					m_min = data[i*offset];
+				}
 			}
-			if (m_min > data[i*offset]) {
-				m_min = data[i*offset];
+		} else {
+			//missing values are masked to NaN in the same loop, the comparisons skip them
+			size_t missing = 0;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i*offset];
+				missing += isMissing(value);
+				const double masked = maskMissing(value);
+				if (m_max < masked) {
+					m_max = masked;
+				}
+				if (m_min > masked) {
+					m_min = masked;
+				}
 			}
+			m_missingCount += missing;
 		}
 
 		//make sure that the post condition is met
@@ -96,6 +126,7 @@ namespace pulse {
 			std::cerr<<"m_fixpoint was == m_min"<<std::endl;
 			m_min = m_min - m_fixpoint*m_fixpoint  - 1.0;
 		}
+		publish();
 
 		//post condition
 		assert(m_min < m_max);
@@ -103,13 +134,29 @@ namespace pulse {
 		assert(m_max > m_fixpoint);
 	}
 	void NormalizeWithFixpoint::updateScalingFactors(double** const data, size_t offset, size_t num) {
-		for (size_t i = 0; i < num; i++) {
-			if (m_max < data[i][offset]) {
-				m_max = data[i][offset];
+		if (m_missingPolicy == PropagateMissing) {
+			for (size_t i = 0; i < num; i++) {
+				if (m_max < data[i][offset]) {
+					m_max = data[i][offset];
+				}
+				if (m_min > data[i][offset]) {
+					m_min = data[i][offset];
+				}
 			}
-			if (m_min > data[i][offset]) {
-				m_min = data[i][offset];
+		} else {
+			size_t missing = 0;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i][offset];
+				missing += isMissing(value);
+				const double masked = maskMissing(value);
+				if (m_max < masked) {
+					m_max = masked;
+				}
+				if (m_min > masked) {
+					m_min = masked;
+				}
 			}
+			m_missingCount += missing;
 		}
 		//make sure that the post condition is met
 		if (m_max - m_fixpoint == 0.0) {
@@ -120,6 +167,7 @@ namespace pulse {
 			std::cerr<<"m_fixpoint was == m_min"<<std::endl;
 			m_min = m_min - m_fixpoint*m_fixpoint  - 1.0;
 		}
+		publish();
 
 		//post condition
 		assert(m_min < m_max);
@@ -127,6 +175,10 @@ namespace pulse {
 		assert(m_max > m_fixpoint);
 	}
 	void NormalizeWithFixpoint::updateScalingFactors(double value) {
+		if (m_missingPolicy != PropagateMissing && isMissing(value)) {
+			m_missingCount++;
+			return;
+		}
 		if (m_max < value) {
 			m_max = value;
 		}
@@ -142,6 +194,7 @@ namespace pulse {
 			std::cerr<<"m_fixpoint was == m_min"<<std::endl;
 			m_min = m_min - m_fixpoint*m_fixpoint  - 1.0;
 		}
+		publish();
 		
 		//post condition
 		assert(m_min < m_max);
@@ -161,32 +214,56 @@ namespace pulse {
 		updateScalingFactors(data, offset, num);
 	}
 	void NormalizeWithFixpoint::scale(const double* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		const State state = getState();
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			for (size_t i = 0; i < num; i++) {
+				const double value = in[i*inOffset];
+				out[i*outOffset] = imputeMissing(value, scale(value, state), imputed);
+			}
+			return;
+		}
 		for (int i = 0; i < num; i++) {
-			out[i*outOffset] = scale(in[i*inOffset]);
+			out[i*outOffset] = scale(in[i*inOffset], state);
 		}
 	}
 	void NormalizeWithFixpoint::scale(double** data, size_t offset, size_t num) const {
+		const State state = getState();
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i][offset];
+				data[i][offset] = imputeMissing(value, scale(value, state), imputed);
+			}
+			return;
+		}
 		for (size_t i = 0; i < num; i++) {
-			data[i][offset] = scale(data[i][offset]);
+			data[i][offset] = scale(data[i][offset], state);
 		}
 	}
 	double NormalizeWithFixpoint::scale(double value) const {
+		if (m_missingPolicy == ImputeMissing) {
+			return imputeMissing(value, scale(value, getState()), m_imputedValue);
+		}
+		return scale(value, getState());
+	}
+	double NormalizeWithFixpoint::scale(double value, const State& state) const {
 		double re = 0.0;
-		if (value < m_fixpoint) {
+		if (value < state.fixpoint) {
 			// [m_min, m_fixpoint) -> [0,1) ...min<----f...
-			double normFixDist = (m_fixpoint-value)/(m_fixpoint-m_min);
+			double normFixDist = (state.fixpoint-value)/(state.fixpoint-state.min);
 			// [0,1) -> [m_norMin,m_normFixpoint)
-			re = m_fixpointNorm-((m_fixpointNorm-m_minNorm)*normFixDist);
+			re = state.fixpointNorm-((state.fixpointNorm-state.minNorm)*normFixDist);
 		} else {
 			// [m_fixpoint,m_max] -> [0,1] f---->max....]
-			double normFixDist = (value-m_fixpoint)/(m_max-m_fixpoint);
+			double normFixDist = (value-state.fixpoint)/(state.max-state.fixpoint);
 			// [0,1] -> [m_normFixpoint,m_normMax]
-			re = m_fixpointNorm + ((m_maxNorm-m_fixpointNorm)*normFixDist);
+			re = state.fixpointNorm + ((state.maxNorm-state.fixpointNorm)*normFixDist);
 		}
-		if (re+0.00000000001 < m_minNorm) {
+		if (re+0.00000000001 < state.minNorm) {
 			std::cerr<<"got value that resulted in a value that was smaller than the m_minNorm"<<std::endl;
 			return re;
-		} else if (re > m_maxNorm) {
+		} else if (re > state.maxNorm) {
 			std::cerr<<"got value that resulted in a value that was bigger than the m_maxNorm"<<std::endl;
 			return re;
 		} else {
@@ -194,26 +271,42 @@ namespace pulse {
 		}
 	}
 	double NormalizeWithFixpoint::originalValue(double value) const {
-		if (value < m_fixpointNorm) {
+		const State state = getState();
+		if (value < state.fixpointNorm) {
 			//[m_minNorm, m_fixpointNorm) -> [0,1)   ...maxN<----fNorm....
-			double normFixDist = (m_fixpointNorm-value)/(m_fixpointNorm-m_minNorm);
+			double normFixDist = (state.fixpointNorm-value)/(state.fixpointNorm-state.minNorm);
 			//[0,1) -> [m_min,m_fixpoint)
-			return m_fixpoint -((m_fixpoint-m_min)*normFixDist);
+			return state.fixpoint -((state.fixpoint-state.min)*normFixDist);
 		} else {
 			//[m_fixpointNorm, m_maxNorm] -> [0,1]   ...fNorm---->minN...
-			double normFixDist = (value-m_fixpointNorm)/(m_maxNorm-m_fixpointNorm);
+			double normFixDist = (value-state.fixpointNorm)/(state.maxNorm-state.fixpointNorm);
 			//[0,1] -> [m_fixpoint,m_max]
-			return m_fixpoint + ((m_max-m_fixpoint)*normFixDist);
+			return state.fixpoint + ((state.max-state.fixpoint)*normFixDist);
 		}
 	}
+	bool NormalizeWithFixpoint::getPiecewiseLinear(PiecewiseLinear& function) const {
+		const State state = getState();
+		function = PiecewiseLinear(state.fixpoint, state.fixpointNorm, (state.fixpointNorm-state.minNorm)/(state.fixpoint-state.min), (state.maxNorm-state.fixpointNorm)/(state.max-state.fixpoint));
+		return true;
+	}
+	bool NormalizeWithFixpoint::isExtremaSufficient() const {
+		return true;
+	}
+	bool NormalizeWithFixpoint::getNormRange(double& minNorm, double& maxNorm) const {
+		const State state = getState();
+		minNorm = state.minNorm;
+		maxNorm = state.maxNorm;
+		return true;
+	}
 	void NormalizeWithFixpoint::getParameters(std::vector<double>& params) const {
 		assert(params.empty());
-		params.push_back(m_min);
-		params.push_back(m_max);
-		params.push_back(m_fixpoint);
-		params.push_back(m_fixpointNorm);
-		params.push_back(m_minNorm);
-		params.push_back(m_maxNorm);
+		const State state = getState();
+		params.push_back(state.min);
+		params.push_back(state.max);
+		params.push_back(state.fixpoint);
+		params.push_back(state.fixpointNorm);
+		params.push_back(state.minNorm);
+		params.push_back(state.maxNorm);
 	}
 	void NormalizeWithFixpoint::setParameters(const std::vector<double>& params) {
 		assert(params.size() == 6);
@@ -223,11 +316,77 @@ namespace pulse {
 		m_fixpointNorm = params[3];
 		m_minNorm = params[4];
 		m_maxNorm = params[5];
+		publish();
 	}
 	const std::string& NormalizeWithFixpoint::getTypeName() const {
 		return m_name;
 	}
 	 Scaler* NormalizeWithFixpoint::clone() const {
-		return new NormalizeWithFixpoint(m_fixpoint, m_fixpointNorm, m_minNorm, m_maxNorm, m_min, m_max);
+		const State state = getState();
+		NormalizeWithFixpoint* re = new NormalizeWithFixpoint(state.fixpoint, state.fixpointNorm, state.minNorm, state.maxNorm, state.min, state.max);
+		re->setConcurrent(m_concurrent);
+		re->setMissingValuePolicy(m_missingPolicy, m_imputedValue);
+		re->m_missingCount = m_missingCount;
+		return re;
 	 }
+	void NormalizeWithFixpoint::merge(const Scaler& other) {
+		checkMergeable(other);
+		const NormalizeWithFixpoint& o = static_cast<const NormalizeWithFixpoint&>(other);
+		if (o.m_fixpoint != m_fixpoint || o.m_fixpointNorm != m_fixpointNorm) {
+			throw MergeException("NormalizeWithFixpoint scalers with different fixpoints can not be merged");
+		}
+		if (m_min > o.m_min) {
+			m_min = o.m_min;
+		}
+		if (m_max < o.m_max) {
+			m_max = o.m_max;
+		}
+		m_missingCount += o.m_missingCount;
+		publish();
+		//post condition
+		assert(m_min < m_fixpoint);
+		assert(m_max > m_fixpoint);
+	}
+	bool NormalizeWithFixpoint::setConcurrent(bool concurrent) {
+		m_concurrent = concurrent;
+		publish();
+		return true;
+	}
+	bool NormalizeWithFixpoint::setMissingValuePolicy(MissingValuePolicy policy, double imputedValue) {
+		m_missingPolicy = policy;
+		m_imputedValue = imputedValue;
+		return true;
+	}
+	MissingValuePolicy NormalizeWithFixpoint::getMissingValuePolicy(double& imputedValue) const {
+		imputedValue = m_imputedValue;
+		return m_missingPolicy;
+	}
+	size_t NormalizeWithFixpoint::getMissingCount() const {
+		return m_missingCount;
+	}
+	NormalizeWithFixpoint::State NormalizeWithFixpoint::getState() const {
+		if (m_concurrent) {
+			return m_published.load();
+		}
+		State state;
+		state.min = m_min;
+		state.max = m_max;
+		state.fixpoint = m_fixpoint;
+		state.fixpointNorm = m_fixpointNorm;
+		state.minNorm = m_minNorm;
+		state.maxNorm = m_maxNorm;
+		return state;
+	}
+	void NormalizeWithFixpoint::publish() {
+		if (m_concurrent) {
+			State state;
+			state.min = m_min;
+			state.max = m_max;
+			state.fixpoint = m_fixpoint;
+			state.fixpointNorm = m_fixpointNorm;
+			state.minNorm = m_minNorm;
+			state.maxNorm = m_maxNorm;
+			m_published.store(state);
+		}
+	}
 }
\ No newline at end of file
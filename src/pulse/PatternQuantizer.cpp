@@ -0,0 +1,180 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <pulse/PatternQuantizer.h>
+#include "ScalingHelpers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <pulse/Instrumentation.h>
+
+namespace pulse {
+	namespace {
+		using detail::imputeMissing;
+		using detail::selectBySign;
+		
+		/** Evaluates the shifted scaling functions, saturates the results to [0, span] and truncates them. Without branches, so the loop is vectorized. */
+		template<class T>
+		void quantizePattern(double const* in, T* out, const double* pivot, const double* pivotValue, const double* slopeBelow, const double* slopeAbove, double span, int minValue, size_t num) {
+			for (size_t i = 0; i < num; i++) {
+				const double d = in[i] - pivot[i];
+				double v = pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]);
+				v = selectBySign(v, 0.0, v);
+				v = selectBySign(span - v, span, v);
+				out[i] = static_cast<T>(static_cast<int32_t>(v) + minValue);
+			}
+		}
+		/** quantizePattern() that replaces the results of missing values by imputed before the saturation */
+		template<class T>
+		void quantizePatternImputing(double const* in, T* out, const double* pivot, const double* pivotValue, const double* slopeBelow, const double* slopeAbove, const double* imputed, double span, int minValue, size_t num) {
+			for (size_t i = 0; i < num; i++) {
+				const double d = in[i] - pivot[i];
+				double v = imputeMissing(in[i], pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]), imputed[i]);
+				v = selectBySign(v, 0.0, v);
+				v = selectBySign(span - v, span, v);
+				out[i] = static_cast<T>(static_cast<int32_t>(v) + minValue);
+			}
+		}
+	}
+	
+	PatternQuantizer::PatternQuantizer(const PatternScaler& patternScaler, unsigned int bits) :
+		m_bits(bits),
+		m_minValue(-(1 << (bits-1))),
+		m_span((1 << bits) - 1),
+		m_quantization(patternScaler.numInputDimensions()),
+		m_pivot(patternScaler.numInputDimensions(), 0.0),
+		m_pivotValue(patternScaler.numInputDimensions(), 0.0),
+		m_slopeBelow(patternScaler.numInputDimensions(), 1.0),
+		m_slopeAbove(patternScaler.numInputDimensions(), 1.0)
+	{
+		assert(bits == 8 || bits == 16);
+		double imputedValue;
+		if (patternScaler.getMissingValuePolicy(imputedValue) == ImputeMissing) {
+			m_imputed.resize(m_quantization.size(), 0.0);
+		}
+		for (size_t i = 0; i < m_quantization.size(); i++) {
+			const Scaler& scaler = patternScaler.getInputScaler(i);
+			double minNorm;
+			double maxNorm;
+			const bool bounded = scaler.getNormRange(minNorm, maxNorm);
+			assert(bounded);
+			(void)bounded;
+			Quantization& quantization = m_quantization[i];
+			quantization.scale = (maxNorm - minNorm)/m_span;
+			const double zeroPoint = m_minValue - std::floor(minNorm/quantization.scale + 0.5);
+			quantization.zeroPoint = static_cast<int>(std::max(static_cast<double>(m_minValue), std::min(m_minValue + m_span, zeroPoint)));
+			if (!m_imputed.empty()) {
+				m_imputed[i] = imputedValue/quantization.scale + quantization.zeroPoint - m_minValue + 0.5;
+			}
+			
+			PiecewiseLinear function;
+			if (scaler.getPiecewiseLinear(function)) {
+				m_pivot[i] = function.pivot;
+				m_pivotValue[i] = function.pivotValue/quantization.scale + quantization.zeroPoint - m_minValue + 0.5;
+				m_slopeBelow[i] = function.slopeBelow/quantization.scale;
+				m_slopeAbove[i] = function.slopeAbove/quantization.scale;
+			} else {
+				m_fallback.push_back(i);
+				m_fallbackScalers.push_back(scaler.clone());
+			}
+		}
+	}
+	PatternQuantizer::~PatternQuantizer() {
+		std::vector<Scaler*>::iterator it;
+		for (it = m_fallbackScalers.begin(); it != m_fallbackScalers.end(); it++) {
+			delete *it;
+		}
+	}
+	
+	template<class T>
+	void PatternQuantizer::quantize(double const* values, T* out) const {
+		const size_t num = m_quantization.size();
+		if (num > 0 && !m_imputed.empty()) {
+			quantizePatternImputing(values, out, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], &m_imputed[0], m_span, m_minValue, num);
+		} else if (num > 0) {
+			quantizePattern(values, out, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], m_span, m_minValue, num);
+		}
+		for (size_t i = 0; i < m_fallback.size(); i++) {
+			const size_t dimension = m_fallback[i];
+			const Quantization& quantization = m_quantization[dimension];
+			double v = m_fallbackScalers[i]->scale(values[dimension])/quantization.scale + quantization.zeroPoint - m_minValue + 0.5;
+			v = std::max(0.0, std::min(m_span, v));
+			out[dimension] = static_cast<T>(static_cast<int32_t>(v) + m_minValue);
+		}
+	}
+	
+	void PatternQuantizer::quantizeInput(double const* values, int8_t* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_quantization.size());
+		assert(m_bits == 8);
+		quantize(values, out);
+	}
+	void PatternQuantizer::quantizeInput(double const* values, int16_t* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_quantization.size());
+		assert(m_bits == 16);
+		quantize(values, out);
+	}
+	void PatternQuantizer::quantizeInputs(const NPP2::PatternSet& patternSet, int8_t* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_quantization.size());
+		assert(m_bits == 8);
+		assert(patternSet.input_count == m_quantization.size());
+		for (size_t i = 0; i < patternSet.pattern_count; i++) {
+			quantize(patternSet.input[i], out + i*m_quantization.size());
+		}
+	}
+	void PatternQuantizer::quantizeInputs(const NPP2::PatternSet& patternSet, int16_t* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_quantization.size());
+		assert(m_bits == 16);
+		assert(patternSet.input_count == m_quantization.size());
+		for (size_t i = 0; i < patternSet.pattern_count; i++) {
+			quantize(patternSet.input[i], out + i*m_quantization.size());
+		}
+	}
+	
+	const PatternQuantizer::Quantization& PatternQuantizer::getQuantization(size_t dimension) const {
+		assert(dimension < m_quantization.size());
+		return m_quantization[dimension];
+	}
+	unsigned int PatternQuantizer::getBits() const {
+		return m_bits;
+	}
+	size_t PatternQuantizer::numInputDimensions() const {
+		return m_quantization.size();
+	}
+}
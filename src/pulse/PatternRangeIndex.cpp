@@ -0,0 +1,217 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/PatternRangeIndex.h>
+
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+namespace pulse {
+	namespace {
+		/** Extends min and max by values[i] with \f$i \in {begin...end-1}\f$ */
+		inline void scanExtrema(const double* values, size_t begin, size_t end, double& min, double& max) {
+			for (size_t i = begin; i < end; i++) {
+				min = std::min(min, values[i]);
+				max = std::max(max, values[i]);
+			}
+		}
+		/** floor(log2(n))
+		 *  \pre n > 0
+		 */
+		inline size_t floorLog2(size_t n) {
+			size_t re = 0;
+			while (n >>= 1) {
+				re++;
+			}
+			return re;
+		}
+	}
+	
+	PatternRangeIndex::Range::Range(size_t begin, size_t end) :
+		begin(begin),
+		end(end)
+	{
+		assert(begin <= end);
+	}
+	
+	PatternRangeIndex::PatternRangeIndex(const NPP2::PatternSet& patternSet, size_t blockSize) :
+		m_numPatterns(patternSet.pattern_count),
+		m_blockSize(blockSize),
+		m_numBlocks(patternSet.pattern_count/blockSize),
+		m_inputs(patternSet.input_count),
+		m_targets(patternSet.target_count)
+	{
+		assert(blockSize > 0);
+		size_t offset = 0;
+		for (size_t width = 1; width <= m_numBlocks; width *= 2) {
+			m_levelOffsets.push_back(offset);
+			offset += m_numBlocks - width + 1;
+		}
+		//copy the values column by column, so the partial blocks are scanned contiguously
+		for (size_t j = 0; j < m_inputs.size(); j++) {
+			m_inputs[j].values.resize(m_numPatterns);
+		}
+		for (size_t j = 0; j < m_targets.size(); j++) {
+			m_targets[j].values.resize(m_numPatterns);
+		}
+		for (size_t i = 0; i < m_numPatterns; i++) {
+			for (size_t j = 0; j < m_inputs.size(); j++) {
+				m_inputs[j].values[i] = patternSet.input[i][j];
+			}
+			for (size_t j = 0; j < m_targets.size(); j++) {
+				m_targets[j].values[i] = patternSet.target[i][j];
+			}
+		}
+		{
+			std::vector<Column>::iterator it;
+			for (it = m_inputs.begin(); it != m_inputs.end(); it++) {
+				build(*it);
+			}
+			for (it = m_targets.begin(); it != m_targets.end(); it++) {
+				build(*it);
+			}
+		}
+	}
+	void PatternRangeIndex::build(Column& column) const {
+		const size_t size = m_levelOffsets.empty() ? 0 : m_levelOffsets.back() + m_numBlocks - (static_cast<size_t>(1) << (m_levelOffsets.size() - 1)) + 1;
+		column.min.resize(size);
+		column.max.resize(size);
+		//level 0 are the extrema of the blocks
+		for (size_t b = 0; b < m_numBlocks; b++) {
+			double min = std::numeric_limits<double>::infinity();
+			double max = -std::numeric_limits<double>::infinity();
+			scanExtrema(&column.values[0], b*m_blockSize, (b+1)*m_blockSize, min, max);
+			column.min[b] = min;
+			column.max[b] = max;
+		}
+		//level l combines two neighbouring entries of level l-1
+		for (size_t l = 1; l < m_levelOffsets.size(); l++) {
+			const size_t half = static_cast<size_t>(1) << (l - 1);
+			const size_t previous = m_levelOffsets[l-1];
+			const size_t current = m_levelOffsets[l];
+			const size_t num = m_numBlocks - 2*half + 1;
+			for (size_t b = 0; b < num; b++) {
+				column.min[current+b] = std::min(column.min[previous+b], column.min[previous+b+half]);
+				column.max[current+b] = std::max(column.max[previous+b], column.max[previous+b+half]);
+			}
+		}
+	}
+	void PatternRangeIndex::getExtrema(const Column& column, const Range& range, double& min, double& max) const {
+		assert(range.begin < range.end);
+		assert(range.end <= m_numPatterns);
+		const double* values = &column.values[0];
+		//whole blocks in the range
+		const size_t firstBlock = (range.begin + m_blockSize - 1)/m_blockSize;
+		const size_t lastBlock = range.end/m_blockSize;
+		if (firstBlock >= lastBlock) {
+			scanExtrema(values, range.begin, range.end, min, max);
+			return;
+		}
+		scanExtrema(values, range.begin, firstBlock*m_blockSize, min, max);
+		scanExtrema(values, lastBlock*m_blockSize, range.end, min, max);
+		//two overlapping power of two spans cover the blocks
+		const size_t l = floorLog2(lastBlock - firstBlock);
+		const size_t offset = m_levelOffsets[l];
+		const size_t second = lastBlock - (static_cast<size_t>(1) << l);
+		min = std::min(min, std::min(column.min[offset+firstBlock], column.min[offset+second]));
+		max = std::max(max, std::max(column.max[offset+firstBlock], column.max[offset+second]));
+	}
+	void PatternRangeIndex::getInputExtrema(size_t dimension, const Range& range, double& min, double& max) const {
+		assert(dimension < m_inputs.size());
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		getExtrema(m_inputs[dimension], range, min, max);
+	}
+	void PatternRangeIndex::getInputExtrema(size_t dimension, const std::vector<Range>& ranges, double& min, double& max) const {
+		assert(dimension < m_inputs.size());
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		std::vector<Range>::const_iterator it;
+		for (it = ranges.begin(); it != ranges.end(); it++) {
+			if (it->begin < it->end) {
+				getExtrema(m_inputs[dimension], *it, min, max);
+			}
+		}
+		assert(min <= max);
+	}
+	void PatternRangeIndex::getTargetExtrema(size_t dimension, const Range& range, double& min, double& max) const {
+		assert(dimension < m_targets.size());
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		getExtrema(m_targets[dimension], range, min, max);
+	}
+	void PatternRangeIndex::getTargetExtrema(size_t dimension, const std::vector<Range>& ranges, double& min, double& max) const {
+		assert(dimension < m_targets.size());
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		std::vector<Range>::const_iterator it;
+		for (it = ranges.begin(); it != ranges.end(); it++) {
+			if (it->begin < it->end) {
+				getExtrema(m_targets[dimension], *it, min, max);
+			}
+		}
+		assert(min <= max);
+	}
+	const double* PatternRangeIndex::getInputColumn(size_t dimension) const {
+		assert(dimension < m_inputs.size());
+		return m_numPatterns > 0 ? &m_inputs[dimension].values[0] : 0;
+	}
+	const double* PatternRangeIndex::getTargetColumn(size_t dimension) const {
+		assert(dimension < m_targets.size());
+		return m_numPatterns > 0 ? &m_targets[dimension].values[0] : 0;
+	}
+	size_t PatternRangeIndex::numPatterns() const {
+		return m_numPatterns;
+	}
+	size_t PatternRangeIndex::numInputDimensions() const {
+		return m_inputs.size();
+	}
+	size_t PatternRangeIndex::numTargetDimensions() const {
+		return m_targets.size();
+	}
+	std::vector<PatternRangeIndex::Range> PatternRangeIndex::getTrainingRanges(size_t numPatterns, size_t numFolds, size_t fold) {
+		assert(fold < numFolds);
+		const size_t begin = fold*numPatterns/numFolds;
+		const size_t end = (fold+1)*numPatterns/numFolds;
+		std::vector<Range> re;
+		if (begin > 0) {
+			re.push_back(Range(0, begin));
+		}
+		if (end < numPatterns) {
+			re.push_back(Range(end, numPatterns));
+		}
+		return re;
+	}
+}
@@ -36,22 +36,361 @@
  */
 
 #include <pulse/PatternScaler.h>
+#include "ScalingHelpers.h"
 
 #include <cassert>
 #include <sstream>
 #include <pulse/ScalerFactory.h>
 #include <pulse/ScalerSaver.h>
+#include <pulse/Instrumentation.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
 
 namespace pulse {
+	namespace {
+		using detail::isMissing;
+		using detail::imputeMissing;
+		using detail::selectBySign;
+		using detail::BitsOf;
+		
+		inline uint64_t toBits(double value) {
+			uint64_t re;
+			memcpy(&re, &value, sizeof(re));
+			return re;
+		}
+#ifndef NDEBUG
+		/** The range of unscaled values a scaler maps onto its norm range, false if the scaler can not describe it by a PiecewiseLinear function and a norm range */
+		bool getCoveredRange(const Scaler& scaler, double& min, double& max) {
+			PiecewiseLinear function;
+			double minNorm;
+			double maxNorm;
+			if (!scaler.getPiecewiseLinear(function) || !scaler.getNormRange(minNorm, maxNorm)) {
+				return false;
+			}
+			const PiecewiseLinear inverse = function.inverse();
+			min = inverse(minNorm);
+			max = inverse(maxNorm);
+			return true;
+		}
+		/** True if scaler still covers [min, max] up to rounding */
+		bool coversRange(const Scaler& scaler, double min, double max) {
+			double coveredMin;
+			double coveredMax;
+			if (!getCoveredRange(scaler, coveredMin, coveredMax)) {
+				return true;
+			}
+			const double tolerance = 1e-9*(max - min);
+			return coveredMin <= min + tolerance && coveredMax >= max - tolerance;
+		}
+#endif
+		/** True if a value is outside of [min[i], max[i]] or NaN, may also be true for values equal to -0.0. Branchless, the differences and their products with 0 are or-ed, so the loop vectorizes even without 64 bit integer compares */
+		bool anyOutsideRange(const double* values, const double* min, const double* max, size_t num) {
+			uint64_t signs = 0;
+			uint64_t invalid = 0;
+			for (size_t i = 0; i < num; i++) {
+				const double below = values[i] - min[i];
+				const double above = max[i] - values[i];
+				signs |= toBits(below) | toBits(above);
+				//NaN if one of the differences is NaN or infinite
+				invalid |= toBits(below*0.0 + above*0.0);
+			}
+			return (signs >> 63) != 0 || invalid != 0;
+		}
+		
+		/** Applies the PiecewiseLinear function of every dimension to the values of one pattern, computed in T */
+		template<class T, class In, class Out>
+		void transformPattern(const In* in, Out* out, const T* pivot, const T* pivotValue, const T* slopeBelow, const T* slopeAbove, size_t num) {
+			for (size_t i = 0; i < num; i++) {
+				const T d = static_cast<T>(in[i]) - pivot[i];
+				out[i] = static_cast<Out>(pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]));
+			}
+		}
+		/** transformPattern() that replaces the results of missing values by imputed[i] in the same loop, if imputing[i] is ~0 */
+		template<class T, class In, class Out>
+		void transformPatternImputing(const In* in, Out* out, const T* pivot, const T* pivotValue, const T* slopeBelow, const T* slopeAbove, const T* imputed, const typename BitsOf<T>::type* imputing, size_t num) {
+			for (size_t i = 0; i < num; i++) {
+				const T value = static_cast<T>(in[i]);
+				const T d = value - pivot[i];
+				out[i] = static_cast<Out>(imputeMissing(value, pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]), imputed[i], imputing[i]));
+			}
+		}
+		
+		/** transformPattern() for sparse values, the functions are gathered by the dimensions in indices */
+		template<class T>
+		void transformSparse(const size_t* indices, T* values, const T* pivot, const T* pivotValue, const T* slopeBelow, const T* slopeAbove, size_t num) {
+			for (size_t k = 0; k < num; k++) {
+				const size_t i = indices[k];
+				const T d = values[k] - pivot[i];
+				values[k] = pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]);
+			}
+		}
+		/** transformSparse() that replaces the results of missing values by imputed[i] in the same loop, if imputing[i] is ~0 */
+		template<class T>
+		void transformSparseImputing(const size_t* indices, T* values, const T* pivot, const T* pivotValue, const T* slopeBelow, const T* slopeAbove, const T* imputed, const typename BitsOf<T>::type* imputing, size_t num) {
+			for (size_t k = 0; k < num; k++) {
+				const size_t i = indices[k];
+				const T value = values[k];
+				const T d = value - pivot[i];
+				values[k] = imputeMissing(value, pivotValue[i] + d*selectBySign(d, slopeBelow[i], slopeAbove[i]), imputed[i], imputing[i]);
+			}
+		}
+		
+		/** Deletes the scalers and clears the vector */
+		void deleteScalers(std::vector<Scaler*>& scalers) {
+			std::vector<Scaler*>::iterator it;
+			for (it = scalers.begin(); it != scalers.end(); it++) {
+				delete (*it);
+			}
+			scalers.clear();
+		}
+		/** Merges the scalers of other into copies of the scalers of the same dimensions, which are appended to merged. If a merge throws, merged is emptied and the MergeException is thrown again with the dimension in front of its message. */
+		void mergeCopies(const std::vector<Scaler*>& scalers, const std::vector<Scaler*>& other, const std::string& kind, std::vector<Scaler*>& merged) {
+			assert(scalers.size() == other.size());
+			for (size_t i = 0; i < scalers.size(); i++) {
+				merged.push_back(scalers[i]->clone());
+				try {
+					merged.back()->merge(*other[i]);
+				} catch (MergeException& e) {
+					deleteScalers(merged);
+					std::stringstream sstr;
+					sstr<<kind<<(i+1)<<": "<<e.what();
+					throw MergeException(sstr.str());
+				}
+			}
+		}
+		
+		/** Resets the scalers of the inputs or the targets with the patterns in ranges */
+		void resetFromIndex(const std::vector<Scaler*>& scalers, const PatternRangeIndex& index, bool inputs, const std::vector<PatternRangeIndex::Range>& ranges) {
+			for (size_t i = 0; i < scalers.size(); i++) {
+				Scaler* scaler = scalers[i];
+				if (scaler->isExtremaSufficient()) {
+					double extrema[2];
+					if (inputs) {
+						index.getInputExtrema(i, ranges, extrema[0], extrema[1]);
+					} else {
+						index.getTargetExtrema(i, ranges, extrema[0], extrema[1]);
+					}
+					scaler->resetScalingFactors(extrema, 1, 2);
+				} else {
+					const double* column = inputs ? index.getInputColumn(i) : index.getTargetColumn(i);
+					bool reset = true;
+					std::vector<PatternRangeIndex::Range>::const_iterator it;
+					for (it = ranges.begin(); it != ranges.end(); it++) {
+						assert(it->end <= index.numPatterns());
+						if (it->begin == it->end) {
+							continue;
+						}
+						if (reset) {
+							scaler->resetScalingFactors(column + it->begin, 1, it->end - it->begin);
+							reset = false;
+						} else {
+							scaler->updateScalingFactors(column + it->begin, 1, it->end - it->begin);
+						}
+					}
+					assert(!reset);
+				}
+			}
+		}
+		
+		/** The PiecewiseLinear functions of all dimensions as structure of arrays with the precision T, so a pattern is transformed by one vectorizable loop.
+		 *  Dimensions without a PiecewiseLinear function keep the identity and are listed by getFallback(), the caller transforms them afterwards. They are never imputed, their scalers apply their own policies.
+		 */
+		template<class T>
+		class PatternKernel {
+		public:
+			typedef typename BitsOf<T>::type Bits;
+			
+			explicit PatternKernel(size_t numDimensions) :
+				m_pivot(numDimensions, 0),
+				m_pivotValue(numDimensions, 0),
+				m_slopeBelow(numDimensions, 1),
+				m_slopeAbove(numDimensions, 1),
+				m_imputed(numDimensions, 0),
+				m_imputing(numDimensions, 0),
+				m_impute(false)
+			{
+			
+			}
+			/** The scaling functions of scalers (or their inverses), the scaling functions impute like the scalers (see Scaler::getMissingValuePolicy()) */
+			PatternKernel(const std::vector<Scaler*>& scalers, bool inverse) :
+				m_pivot(scalers.size(), 0),
+				m_pivotValue(scalers.size(), 0),
+				m_slopeBelow(scalers.size(), 1),
+				m_slopeAbove(scalers.size(), 1),
+				m_imputed(scalers.size(), 0),
+				m_imputing(scalers.size(), 0),
+				m_impute(false)
+			{
+				for (size_t i = 0; i < scalers.size(); i++) {
+					PiecewiseLinear function;
+					double imputed;
+					if (scalers[i]->getPiecewiseLinear(function)) {
+						setFunction(i, inverse ? function.inverse() : function);
+						if (!inverse && scalers[i]->getMissingValuePolicy(imputed) == ImputeMissing) {
+							setImputedValue(i, imputed);
+						}
+					} else {
+						m_fallback.push_back(i);
+					}
+				}
+			}
+			void setFunction(size_t dimension, const PiecewiseLinear& function) {
+				m_pivot[dimension] = static_cast<T>(function.pivot);
+				m_pivotValue[dimension] = static_cast<T>(function.pivotValue);
+				m_slopeBelow[dimension] = static_cast<T>(function.slopeBelow);
+				m_slopeAbove[dimension] = static_cast<T>(function.slopeAbove);
+			}
+			void addFallback(size_t dimension) {
+				m_fallback.push_back(dimension);
+			}
+			const std::vector<size_t>& getFallback() const {
+				return m_fallback;
+			}
+			/** Replaces the results of missing values of a dimension with a function by imputed, see ImputeMissing */
+			void setImputedValue(size_t dimension, double imputed) {
+				m_impute = true;
+				m_imputed[dimension] = static_cast<T>(imputed);
+				m_imputing[dimension] = ~static_cast<Bits>(0);
+			}
+			/** out[i] = f_i(in[i]) for every dimension i, in and out may be the same */
+			template<class In, class Out>
+			void apply(const In* in, Out* out) const {
+				if (m_pivot.empty()) {
+					return;
+				}
+				if (m_impute) {
+					transformPatternImputing(in, out, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], &m_imputed[0], &m_imputing[0], m_pivot.size());
+				} else {
+					transformPattern(in, out, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], m_pivot.size());
+				}
+			}
+			/** values[k] = f_indices[k](values[k]) for num sparse values */
+			void applySparse(const size_t* indices, T* values, size_t num) const {
+				if (m_pivot.empty()) {
+					return;
+				}
+				if (m_impute) {
+					transformSparseImputing(indices, values, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], &m_imputed[0], &m_imputing[0], num);
+				} else {
+					transformSparse(indices, values, &m_pivot[0], &m_pivotValue[0], &m_slopeBelow[0], &m_slopeAbove[0], num);
+				}
+			}
+		private:
+			std::vector<T> m_pivot;
+			std::vector<T> m_pivotValue;
+			std::vector<T> m_slopeBelow;
+			std::vector<T> m_slopeAbove;
+			std::vector<size_t> m_fallback;
+			/** The imputed value of every dimension and ~0 for the dimensions that impute */
+			std::vector<T> m_imputed;
+			std::vector<Bits> m_imputing;
+			bool m_impute;
+		};
+		
+		/** Rescales num patterns that were scaled by previous to the scaling of scalers, see Scaler::rescale() */
+		void rescalePatterns(const std::vector<Scaler*>& scalers, const std::vector<Scaler*>& previous, double** data, size_t num) {
+			assert(scalers.size() == previous.size());
+			PatternKernel<double> kernel(scalers.size());
+			for (size_t i = 0; i < scalers.size(); i++) {
+				PiecewiseLinear function;
+				double imputed;
+				if (scalers[i]->getRescaling(*previous[i], function)) {
+					kernel.setFunction(i, function);
+					if (scalers[i]->getMissingValuePolicy(imputed) == ImputeMissing) {
+						kernel.setImputedValue(i, imputed);
+					}
+				} else {
+					kernel.addFallback(i);
+				}
+			}
+			for (size_t i = 0; i < num; i++) {
+				kernel.apply(data[i], data[i]);
+			}
+			std::vector<size_t>::const_iterator it;
+			for (it = kernel.getFallback().begin(); it != kernel.getFallback().end(); it++) {
+				scalers[*it]->rescale(*previous[*it], data, *it, num);
+			}
+		}
+		
+		/** Scales the values of num patterns of a PatternSet into rows of floats, the scaling is computed in double */
+		void scalePatternsToFloats(const std::vector<Scaler*>& scalers, double** data, size_t num, float* out) {
+			const size_t dimensions = scalers.size();
+			PatternKernel<double> kernel(scalers, false);
+			for (size_t i = 0; i < num; i++) {
+				kernel.apply(data[i], out + i*dimensions);
+			}
+			std::vector<size_t>::const_iterator it;
+			for (it = kernel.getFallback().begin(); it != kernel.getFallback().end(); it++) {
+				for (size_t i = 0; i < num; i++) {
+					out[i*dimensions + *it] = static_cast<float>(scalers[*it]->scale(data[i][*it]));
+				}
+			}
+		}
+		
+		/** Returns the slope and the intercept of every scaler and the dimensions of the scalers that are not affine, these get the identity */
+		std::vector<size_t> getAffineCoefficients(const std::vector<Scaler*>& scalers, std::vector<double>& slopes, std::vector<double>& intercepts) {
+			slopes.assign(scalers.size(), 1.0);
+			intercepts.assign(scalers.size(), 0.0);
+			std::vector<size_t> notAffine;
+			for (size_t i = 0; i < scalers.size(); i++) {
+				PiecewiseLinear function;
+				if (scalers[i]->getPiecewiseLinear(function) && function.isAffine()) {
+					slopes[i] = function.slope();
+					intercepts[i] = function.intercept();
+				} else {
+					notAffine.push_back(i);
+				}
+			}
+			return notAffine;
+		}
+		/** weights*(slopes*x + intercepts) + bias as new weights and bias, weights has numRows rows of slopes.size() values */
+		template<class T>
+		void foldIntoInputs(const std::vector<double>& slopes, const std::vector<double>& intercepts, T* weights, T* bias, size_t numRows) {
+			const size_t numColumns = slopes.size();
+			for (size_t r = 0; r < numRows; r++) {
+				T* row = weights + r*numColumns;
+				double shift = 0.0;
+				for (size_t c = 0; c < numColumns; c++) {
+					shift += row[c]*intercepts[c];
+					row[c] = static_cast<T>(row[c]*slopes[c]);
+				}
+				bias[r] = static_cast<T>(bias[r] + shift);
+			}
+		}
+		/** (weights*x + bias - intercepts)/slopes as new weights and bias, weights has slopes.size() rows of numColumns values */
+		template<class T>
+		void foldIntoOutputs(const std::vector<double>& slopes, const std::vector<double>& intercepts, T* weights, T* bias, size_t numColumns) {
+			for (size_t r = 0; r < slopes.size(); r++) {
+				T* row = weights + r*numColumns;
+				const double inverseSlope = 1.0/slopes[r];
+				for (size_t c = 0; c < numColumns; c++) {
+					row[c] = static_cast<T>(row[c]*inverseSlope);
+				}
+				bias[r] = static_cast<T>((bias[r] - intercepts[r])*inverseSlope);
+			}
+		}
+	}
+	
 #ifdef __APPLE__
 #pragma mark Construction, desconstruction and copying
 #endif
 	/** \name Construction, desconstruction and copying
 	 @{ */
-	PatternScaler::PatternScaler() {
+	PatternScaler::PatternScaler() :
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0)
+	{
 	
 	}
-	PatternScaler::PatternScaler(const PatternScaler& other) {
+	PatternScaler::PatternScaler(const PatternScaler& other) :
+		m_inputSeenMin(other.m_inputSeenMin),
+		m_inputSeenMax(other.m_inputSeenMax),
+		m_missingPolicy(other.m_missingPolicy),
+		m_imputedValue(other.m_imputedValue)
+	{
 		{
 			std::vector<Scaler*>::const_iterator it;
 			for(it = other.m_inputScalers.begin(); it != other.m_inputScalers.end(); it++) {
@@ -106,6 +445,10 @@ namespace pulse {
 				m_targetScalers.push_back((*it)->clone());
 			}
 		}
+		m_inputSeenMin = other.m_inputSeenMin;
+		m_inputSeenMax = other.m_inputSeenMax;
+		m_missingPolicy = other.m_missingPolicy;
+		m_imputedValue = other.m_imputedValue;
 		return *this;
 	}
 	/*@}*/
@@ -116,6 +459,8 @@ namespace pulse {
 	/** \name Saving and loading functionality
 	 @{ */
 	void PatternScaler::loadFromFile(const std::string& filename) throw (FileOpenException, ParseException) {
+		PULSE_TIME(LoadTime);
+		PULSE_COUNT(FilesLoaded, 1);
 		//delete the old scalers
 		{
 			std::vector<Scaler*>::iterator it;
@@ -131,6 +476,8 @@ namespace pulse {
 		}
 		m_inputScalers.clear();
 		m_targetScalers.clear();
+		m_inputSeenMin.clear();
+		m_inputSeenMax.clear();
 	
 		//load
 		ScalerFactory factory(filename);
@@ -154,6 +501,8 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::saveToFile(const std::string& filename) const throw (FileOpenException) {
+		PULSE_TIME(SaveTime);
+		PULSE_COUNT(FilesSaved, 1);
 	
 		ScalerSaver saver(filename);
 		{
@@ -186,9 +535,17 @@ namespace pulse {
 	 @{ */
 	void PatternScaler::addInputScaler(const Scaler& scaler) {
 		m_inputScalers.push_back(scaler.clone());
+		m_inputSeenMin.push_back(std::numeric_limits<double>::infinity());
+		m_inputSeenMax.push_back(-std::numeric_limits<double>::infinity());
+		if (m_missingPolicy != PropagateMissing) {
+			m_inputScalers.back()->setMissingValuePolicy(m_missingPolicy, m_imputedValue);
+		}
 	}
 	void PatternScaler::addTargetScaler(const Scaler& scaler) {
 		m_targetScalers.push_back(scaler.clone());
+		if (m_missingPolicy != PropagateMissing) {
+			m_targetScalers.back()->setMissingValuePolicy(m_missingPolicy, m_imputedValue);
+		}
 	}
 	/*@}*/
 #ifdef __APPLE__
@@ -202,9 +559,16 @@ namespace pulse {
 		updateTargetScalers(patternSet);
 		
 	}
+	size_t PatternScaler::updateScalers(const NPP2::PatternSet& patternSet, size_t firstPattern) {
+		updateInputScalers(patternSet, firstPattern);
+		return updateTargetScalers(patternSet, firstPattern);
+	}
 	void PatternScaler::updateInputScalers(const NPP2::PatternSet& patternSet) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, patternSet.pattern_count*m_inputScalers.size());
 		assert(patternSet.input_count == m_inputScalers.size());
 		assert(patternSet.pattern_count > 0);
+		forgetSeenInputRanges();
 		{
 			size_t i = 0;
 			std::vector<Scaler*>::iterator it;
@@ -215,8 +579,20 @@ namespace pulse {
 		}
 		
 	}
+	size_t PatternScaler::updateInputScalers(const NPP2::PatternSet& patternSet, size_t firstPattern) {
+		assert(patternSet.input_count == m_inputScalers.size());
+		assert(firstPattern <= patternSet.pattern_count);
+		if (firstPattern < patternSet.pattern_count) {
+			//the rows are accessed through pointers, so skipping the seen patterns is just an offset
+			updateInputScalers(patternSet.input + firstPattern, patternSet.pattern_count - firstPattern);
+		}
+		return patternSet.pattern_count;
+	}
 	void PatternScaler::updateInputScalers(double** in, size_t num) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, num*m_inputScalers.size());
 		assert(num > 0);
+		forgetSeenInputRanges();
 		{
 			size_t i = 0;
 			std::vector<Scaler*>::iterator it;
@@ -227,14 +603,87 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::updateInputScalers(const std::vector<double>& values, size_t start) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, values.size());
 		assert(values.size() + start <= m_inputScalers.size());
+		if (values.empty()) {
+			return;
+		}
 		
-		std::vector<Scaler*>::iterator it;
-		for (size_t i = 0; i < values.size(); i++) {
-			m_inputScalers[i+start]->updateScalingFactors(values[i]);
+		//the test runs on blocks, so a value outside of its range only costs the scalar test of its block
+		const size_t blockSize = 64;
+		for (size_t block = 0; block < values.size(); block += blockSize) {
+			const size_t num = std::min(blockSize, values.size() - block);
+			const double* value = &values[block];
+			double* min = &m_inputSeenMin[start + block];
+			double* max = &m_inputSeenMax[start + block];
+			if (!anyOutsideRange(value, min, max, num)) {
+				continue;
+			}
+			for (size_t i = 0; i < num; i++) {
+				updateInputScaler(start + block + i, value[i]);
+			}
 		}
 	}
+	void PatternScaler::updateInputScaler(size_t dimension, double value) {
+		double& min = m_inputSeenMin[dimension];
+		double& max = m_inputSeenMax[dimension];
+		if (value >= min && value <= max) {
+			return;
+		}
+		Scaler* scaler = m_inputScalers[dimension];
+		scaler->updateScalingFactors(value);
+		//only finite values are remembered, an infinite bound would hide every later value from a scaler that skips it
+		if (value - value == 0.0 && scaler->isExtremaSufficient()) {
+			min = std::min(min, value);
+			max = std::max(max, value);
+		}
+	}
+	void PatternScaler::updateInputScalerZeros(size_t dimension, size_t num) {
+		if (num == 0) {
+			return;
+		}
+		if (m_inputScalers[dimension]->isExtremaSufficient()) {
+			updateInputScaler(dimension, 0.0);
+		} else {
+			m_inputScalers[dimension]->updateScalingFactorsRepeated(0.0, num);
+		}
+	}
+	std::vector<size_t> PatternScaler::updateInputScalers(const ConcurrentRangeAccumulator& accumulator) {
+		PULSE_TIME(FitTime);
+		assert(accumulator.numDimensions() == m_inputScalers.size());
+		forgetSeenInputRanges();
+		std::vector<size_t> skipped;
+		{
+			size_t i = 0;
+			std::vector<Scaler*>::iterator it;
+			for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+				if (!(*it)->isExtremaSufficient()) {
+					//the extrema would be passed like two values of the data
+					skipped.push_back(i);
+					i++;
+					continue;
+				}
+				double extrema[2];
+				accumulator.getExtrema(i, extrema[0], extrema[1]);
+				if (extrema[0] <= extrema[1]) {
+#ifndef NDEBUG
+					double coveredMin = 0.0;
+					double coveredMax = 0.0;
+					const bool covered = getCoveredRange(**it, coveredMin, coveredMax);
+#endif
+					(*it)->updateScalingFactors(extrema, 1, 2);
+					//folding extrema only extends the fitted range
+					assert(!covered || coversRange(**it, coveredMin, coveredMax));
+				}
+				i++;
+			}
+		}
+		return skipped;
+	}
 	void PatternScaler::updateTargetScalers(const NPP2::PatternSet& patternSet) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, patternSet.pattern_count*m_targetScalers.size());
 		assert(patternSet.target_count == m_targetScalers.size());
 		{
 			size_t i = 0;
@@ -246,6 +695,25 @@ namespace pulse {
 		}
 		
 	}
+	size_t PatternScaler::updateTargetScalers(const NPP2::PatternSet& patternSet, size_t firstPattern) {
+		PULSE_TIME(FitTime);
+		assert(patternSet.target_count == m_targetScalers.size());
+		assert(firstPattern <= patternSet.pattern_count);
+		if (firstPattern == patternSet.pattern_count) {
+			return firstPattern;
+		}
+		size_t num = patternSet.pattern_count - firstPattern;
+		PULSE_COUNT(ValuesFitted, num*m_targetScalers.size());
+		{
+			size_t i = 0;
+			std::vector<Scaler*>::iterator it;
+			for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+				(*it)->updateScalingFactors(patternSet.target + firstPattern, i, num);
+				i++;
+			}
+		}
+		return patternSet.pattern_count;
+	}
 	/*@}*/
 #ifdef __APPLE__
 #pragma mark -
@@ -258,6 +726,9 @@ namespace pulse {
 		resetTargetScalers(patternSet);
 	}
 	void PatternScaler::resetInputScalers(const NPP2::PatternSet& patternSet) {
+		PULSE_TIME(FitTime);
+		forgetSeenInputRanges();
+		PULSE_COUNT(ValuesFitted, patternSet.pattern_count*m_inputScalers.size());
 		assert(patternSet.input_count == m_inputScalers.size());
 		assert(patternSet.pattern_count > 0);
 		{
@@ -270,6 +741,8 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::resetTargetScalers(const NPP2::PatternSet& patternSet) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, patternSet.pattern_count*m_targetScalers.size());
 		assert(patternSet.target_count == m_targetScalers.size());
 		{
 			size_t i = 0;
@@ -281,6 +754,108 @@ namespace pulse {
 		}
 		
 	}
+	void PatternScaler::resetScalers(const PatternRangeIndex& index, const std::vector<PatternRangeIndex::Range>& ranges) {
+		PULSE_TIME(FitTime);
+		assert(index.numInputDimensions() == m_inputScalers.size());
+		assert(index.numTargetDimensions() == m_targetScalers.size());
+		forgetSeenInputRanges();
+		resetFromIndex(m_inputScalers, index, true, ranges);
+		resetFromIndex(m_targetScalers, index, false, ranges);
+	}
+	void PatternScaler::resetScalers(const PatternRangeIndex& index, const PatternRangeIndex::Range& range) {
+		resetScalers(index, std::vector<PatternRangeIndex::Range>(1, range));
+	}
+	void PatternScaler::forgetSeenInputRanges() {
+		m_inputSeenMin.assign(m_inputScalers.size(), std::numeric_limits<double>::infinity());
+		m_inputSeenMax.assign(m_inputScalers.size(), -std::numeric_limits<double>::infinity());
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Merging of fitted scalers
+#endif
+	/** \name Merging of fitted scalers
+	 @{ */
+	void PatternScaler::merge(const PatternScaler& other) throw (MergeException) {
+		if (other.m_inputScalers.size() != m_inputScalers.size() || other.m_targetScalers.size() != m_targetScalers.size()) {
+			throw MergeException("the PatternScalers have different dimensions");
+		}
+		//the scalers are merged into copies, so this is not changed if one of them throws
+		std::vector<Scaler*> inputs;
+		std::vector<Scaler*> targets;
+		mergeCopies(m_inputScalers, other.m_inputScalers, "input", inputs);
+		try {
+			mergeCopies(m_targetScalers, other.m_targetScalers, "target", targets);
+		} catch (MergeException&) {
+			deleteScalers(inputs);
+			throw;
+		}
+		m_inputScalers.swap(inputs);
+		m_targetScalers.swap(targets);
+		deleteScalers(inputs);
+		deleteScalers(targets);
+		forgetSeenInputRanges();
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Concurrent scaling
+#endif
+	/** \name Concurrent scaling
+	 @{ */
+	bool PatternScaler::setConcurrent(bool concurrent) {
+		bool re = true;
+		std::vector<Scaler*>::iterator it;
+		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+			re = (*it)->setConcurrent(concurrent) && re;
+		}
+		for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+			re = (*it)->setConcurrent(concurrent) && re;
+		}
+		return re;
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Missing values
+#endif
+	/** \name Missing values
+	 @{ */
+	bool PatternScaler::setMissingValuePolicy(MissingValuePolicy policy, double imputedValue) {
+		m_missingPolicy = policy;
+		m_imputedValue = imputedValue;
+		bool re = true;
+		std::vector<Scaler*>::iterator it;
+		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+			re = (*it)->setMissingValuePolicy(policy, imputedValue) && re;
+		}
+		for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+			re = (*it)->setMissingValuePolicy(policy, imputedValue) && re;
+		}
+		return re;
+	}
+	MissingValuePolicy PatternScaler::getMissingValuePolicy(double& imputedValue) const {
+		imputedValue = m_imputedValue;
+		return m_missingPolicy;
+	}
+	std::vector<size_t> PatternScaler::getInputMissingCounts() const {
+		std::vector<size_t> re;
+		re.reserve(m_inputScalers.size());
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+			re.push_back((*it)->getMissingCount());
+		}
+		return re;
+	}
+	std::vector<size_t> PatternScaler::getTargetMissingCounts() const {
+		std::vector<size_t> re;
+		re.reserve(m_targetScalers.size());
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+			re.push_back((*it)->getMissingCount());
+		}
+		return re;
+	}
 	/*@}*/
 #ifdef __APPLE__
 #pragma mark -
@@ -293,6 +868,8 @@ namespace pulse {
 		scaleTargets(patternSet);
 	}
 	void PatternScaler::scaleInputs(NPP2::PatternSet& patternSet) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_inputScalers.size());
 		
 		assert(patternSet.input_count == m_inputScalers.size());
 		{
@@ -305,6 +882,8 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::scaleInput(double* values) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_inputScalers.size());
 		size_t i = 0;
 		std::vector<Scaler*>::const_iterator it;
 		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
@@ -313,6 +892,8 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::scaleInput(double* values, size_t startScaler, size_t numScalers) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, numScalers);
 		assert(startScaler+numScalers <= m_inputScalers.size());
 		
 		for (size_t i = 0; i < numScalers; ++i) {
@@ -320,6 +901,8 @@ namespace pulse {
 		}
 	}
 	void PatternScaler::scaleTargets(NPP2::PatternSet& patternSet) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_targetScalers.size());
 		assert(patternSet.target_count == m_targetScalers.size());
 		{
 			size_t i = 0;
@@ -332,6 +915,8 @@ namespace pulse {
 	}
 	
 	double* PatternScaler::copyAndScaleInput(double const* input) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_inputScalers.size());
 		double* result = new double[numInputDimensions()];
 		size_t i = 0;
 		std::vector<Scaler*>::const_iterator it;
@@ -344,11 +929,186 @@ namespace pulse {
 	/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Single precision scaling
+#endif
+	/** \name Single precision scaling
+	 @{ */
+	
+	void PatternScaler::scaleInput(float* values) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, m_inputScalers.size());
+		size_t i = 0;
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+			(*it)->scaleFloats(values + i, 1, values + i, 1, 1);
+			i++;
+		}
+	}
+	void PatternScaler::scaleInputs(float* patterns, size_t numPatterns) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, numPatterns*m_inputScalers.size());
+		const size_t dimensions = m_inputScalers.size();
+		PatternKernel<float> kernel(m_inputScalers, false);
+		for (size_t i = 0; i < numPatterns; i++) {
+			kernel.apply(patterns + i*dimensions, patterns + i*dimensions);
+		}
+		std::vector<size_t>::const_iterator it;
+		for (it = kernel.getFallback().begin(); it != kernel.getFallback().end(); it++) {
+			m_inputScalers[*it]->scaleFloats(patterns + *it, dimensions, patterns + *it, dimensions, numPatterns);
+		}
+	}
+	void PatternScaler::scaleInputs(const NPP2::PatternSet& patternSet, float* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_inputScalers.size());
+		assert(patternSet.input_count == m_inputScalers.size());
+		scalePatternsToFloats(m_inputScalers, patternSet.input, patternSet.pattern_count, out);
+	}
+	void PatternScaler::scaleTargets(const NPP2::PatternSet& patternSet, float* out) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*m_targetScalers.size());
+		assert(patternSet.target_count == m_targetScalers.size());
+		scalePatternsToFloats(m_targetScalers, patternSet.target, patternSet.pattern_count, out);
+	}
+	void PatternScaler::originalTargetValues(float* values) const {
+		PULSE_TIME(RestoreTime);
+		PULSE_COUNT(ValuesRestored, m_targetScalers.size());
+		size_t i = 0;
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+			(*it)->originalFloatValues(values + i, 1, values + i, 1, 1);
+			i++;
+		}
+	}
+	void PatternScaler::originalTargetValues(float* patterns, size_t numPatterns) const {
+		PULSE_TIME(RestoreTime);
+		PULSE_COUNT(ValuesRestored, numPatterns*m_targetScalers.size());
+		const size_t dimensions = m_targetScalers.size();
+		PatternKernel<float> kernel(m_targetScalers, true);
+		for (size_t i = 0; i < numPatterns; i++) {
+			kernel.apply(patterns + i*dimensions, patterns + i*dimensions);
+		}
+		std::vector<size_t>::const_iterator it;
+		for (it = kernel.getFallback().begin(); it != kernel.getFallback().end(); it++) {
+			m_targetScalers[*it]->originalFloatValues(patterns + *it, dimensions, patterns + *it, dimensions, numPatterns);
+		}
+	}
+	
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Sparse input patterns
+#endif
+	/** \name Sparse input patterns
+	 @{ */
+	void PatternScaler::updateInputScalers(const size_t* rowStart, const size_t* indices, const double* values, size_t numPatterns) {
+		PULSE_TIME(FitTime);
+		PULSE_COUNT(ValuesFitted, rowStart[numPatterns] - rowStart[0]);
+		const size_t dimensions = m_inputScalers.size();
+		//number of patterns of every dimension that were passed to its scaler, the zeros behind them are passed in front of the next stored value
+		std::vector<size_t> numPassed(dimensions, 0);
+		for (size_t p = 0; p < numPatterns; p++) {
+			for (size_t k = rowStart[p]; k < rowStart[p+1]; k++) {
+				const size_t i = indices[k];
+				assert(i < dimensions);
+				assert(numPassed[i] <= p);
+				updateInputScalerZeros(i, p - numPassed[i]);
+				updateInputScaler(i, values[k]);
+				numPassed[i] = p+1;
+			}
+		}
+		for (size_t i = 0; i < dimensions; i++) {
+			updateInputScalerZeros(i, numPatterns - numPassed[i]);
+		}
+	}
+	void PatternScaler::scaleInputs(const size_t* rowStart, const size_t* indices, double* values, size_t numPatterns) const {
+		PULSE_TIME(ScaleTime);
+		const size_t first = rowStart[0];
+		const size_t num = rowStart[numPatterns] - first;
+		PULSE_COUNT(ValuesScaled, num);
+		indices += first;
+		values += first;
+		if (num < 4*m_inputScalers.size()) {
+			//building the kernel costs about two virtual calls per dimension, it only pays off for several values per dimension
+			for (size_t k = 0; k < num; k++) {
+				assert(indices[k] < m_inputScalers.size());
+				values[k] = m_inputScalers[indices[k]]->scale(values[k]);
+			}
+			return;
+		}
+		PatternKernel<double> kernel(m_inputScalers, false);
+		kernel.applySparse(indices, values, num);
+		if (!kernel.getFallback().empty()) {
+			//the kernel kept the values of these dimensions
+			std::vector<bool> fallback(m_inputScalers.size(), false);
+			std::vector<size_t>::const_iterator it;
+			for (it = kernel.getFallback().begin(); it != kernel.getFallback().end(); it++) {
+				fallback[*it] = true;
+			}
+			for (size_t k = 0; k < num; k++) {
+				if (fallback[indices[k]]) {
+					values[k] = m_inputScalers[indices[k]]->scale(values[k]);
+				}
+			}
+		}
+	}
+	std::vector<double> PatternScaler::getScaledInputZeros() const {
+		std::vector<double> re;
+		re.reserve(m_inputScalers.size());
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+			re.push_back((*it)->scale(0.0));
+		}
+		return re;
+	}
+	
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Rescaling of scaled data
+#endif
+	/** \name Rescaling of scaled data
+	 @{ */
+	void PatternScaler::rescale(const PatternScaler& previous, NPP2::PatternSet& patternSet) const {
+		rescale(previous, patternSet, patternSet.pattern_count);
+	}
+	void PatternScaler::rescale(const PatternScaler& previous, NPP2::PatternSet& patternSet, size_t numScaled) const {
+		PULSE_TIME(ScaleTime);
+		PULSE_COUNT(ValuesScaled, patternSet.pattern_count*(m_inputScalers.size() + m_targetScalers.size()));
+		assert(previous.m_inputScalers.size() == m_inputScalers.size());
+		assert(previous.m_targetScalers.size() == m_targetScalers.size());
+		assert(patternSet.input_count == m_inputScalers.size());
+		assert(patternSet.target_count == m_targetScalers.size());
+		assert(numScaled <= patternSet.pattern_count);
+		
+		rescalePatterns(m_inputScalers, previous.m_inputScalers, patternSet.input, numScaled);
+		rescalePatterns(m_targetScalers, previous.m_targetScalers, patternSet.target, numScaled);
+		
+		//the appended patterns are not scaled yet
+		const size_t numAppended = patternSet.pattern_count - numScaled;
+		if (numAppended > 0) {
+			size_t i = 0;
+			std::vector<Scaler*>::const_iterator it;
+			for (it = m_inputScalers.begin(); it != m_inputScalers.end(); it++) {
+				(*it)->scale(patternSet.input + numScaled, i, numAppended);
+				i++;
+			}
+			i = 0;
+			for (it = m_targetScalers.begin(); it != m_targetScalers.end(); it++) {
+				(*it)->scale(patternSet.target + numScaled, i, numAppended);
+				i++;
+			}
+		}
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Restoring the original values from scaled values
 #endif
 	/** \name Restoring the original values from scaled values
 	 @{ */
 	void PatternScaler::originalTargetValues(double* values) const {
+		PULSE_TIME(RestoreTime);
+		PULSE_COUNT(ValuesRestored, m_targetScalers.size());
 		{
 			size_t i = 0;
 			std::vector<Scaler*>::const_iterator it;
@@ -362,6 +1122,49 @@ namespace pulse {
 	/*@}*/
 #ifdef __APPLE__
 #pragma mark -
+#pragma mark Folding the scaling into a network
+#endif
+	/** \name Folding the scaling into a network
+	 @{ */
+	
+	std::vector<size_t> PatternScaler::getInputCoefficients(std::vector<double>& slopes, std::vector<double>& intercepts) const {
+		return getAffineCoefficients(m_inputScalers, slopes, intercepts);
+	}
+	std::vector<size_t> PatternScaler::getTargetCoefficients(std::vector<double>& slopes, std::vector<double>& intercepts) const {
+		return getAffineCoefficients(m_targetScalers, slopes, intercepts);
+	}
+	std::vector<size_t> PatternScaler::foldIntoFirstLayer(double* weights, double* bias, size_t numNeurons) const {
+		std::vector<double> slopes;
+		std::vector<double> intercepts;
+		const std::vector<size_t> notAffine = getInputCoefficients(slopes, intercepts);
+		foldIntoInputs(slopes, intercepts, weights, bias, numNeurons);
+		return notAffine;
+	}
+	std::vector<size_t> PatternScaler::foldIntoFirstLayer(float* weights, float* bias, size_t numNeurons) const {
+		std::vector<double> slopes;
+		std::vector<double> intercepts;
+		const std::vector<size_t> notAffine = getInputCoefficients(slopes, intercepts);
+		foldIntoInputs(slopes, intercepts, weights, bias, numNeurons);
+		return notAffine;
+	}
+	std::vector<size_t> PatternScaler::foldIntoLastLayer(double* weights, double* bias, size_t numHidden) const {
+		std::vector<double> slopes;
+		std::vector<double> intercepts;
+		const std::vector<size_t> notAffine = getTargetCoefficients(slopes, intercepts);
+		foldIntoOutputs(slopes, intercepts, weights, bias, numHidden);
+		return notAffine;
+	}
+	std::vector<size_t> PatternScaler::foldIntoLastLayer(float* weights, float* bias, size_t numHidden) const {
+		std::vector<double> slopes;
+		std::vector<double> intercepts;
+		const std::vector<size_t> notAffine = getTargetCoefficients(slopes, intercepts);
+		foldIntoOutputs(slopes, intercepts, weights, bias, numHidden);
+		return notAffine;
+	}
+	
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
 #pragma mark Dimension informations
 #endif
 	/** \name Dimension informations
@@ -373,6 +1176,14 @@ namespace pulse {
 	size_t PatternScaler::numTargetDimensions() const {
 		return m_targetScalers.size();
 	}
+	const Scaler& PatternScaler::getInputScaler(size_t dimension) const {
+		assert(dimension < m_inputScalers.size());
+		return *m_inputScalers[dimension];
+	}
+	const Scaler& PatternScaler::getTargetScaler(size_t dimension) const {
+		assert(dimension < m_targetScalers.size());
+		return *m_targetScalers[dimension];
+	}
 	
 	/*@}*/
 #ifdef __APPLE__
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/PiecewiseLinear.h>
+
+#include <cassert>
+
+namespace pulse {
+	PiecewiseLinear::PiecewiseLinear() :
+		pivot(0.0),
+		pivotValue(0.0),
+		slopeBelow(1.0),
+		slopeAbove(1.0)
+	{
+	
+	}
+	PiecewiseLinear::PiecewiseLinear(double pivot, double pivotValue, double slopeBelow, double slopeAbove) :
+		pivot(pivot),
+		pivotValue(pivotValue),
+		slopeBelow(slopeBelow),
+		slopeAbove(slopeAbove)
+	{
+		assert(slopeBelow > 0.0);
+		assert(slopeAbove > 0.0);
+	}
+	PiecewiseLinear PiecewiseLinear::affine(double slope, double intercept) {
+		return PiecewiseLinear(0.0, intercept, slope, slope);
+	}
+	bool PiecewiseLinear::isAffine() const {
+		return (slopeBelow == slopeAbove);
+	}
+	double PiecewiseLinear::slope() const {
+		assert(isAffine());
+		return slopeAbove;
+	}
+	double PiecewiseLinear::intercept() const {
+		assert(isAffine());
+		return pivotValue - pivot*slopeAbove;
+	}
+	PiecewiseLinear PiecewiseLinear::inverse() const {
+		return PiecewiseLinear(pivotValue, pivot, 1.0/slopeBelow, 1.0/slopeAbove);
+	}
+	bool PiecewiseLinear::compose(const PiecewiseLinear& outer, const PiecewiseLinear& inner, PiecewiseLinear& result) {
+		if (outer.isAffine()) {
+			//the kink of inner stays where it is
+			result = PiecewiseLinear(inner.pivot, outer(inner.pivotValue), outer.slopeAbove*inner.slopeBelow, outer.slopeAbove*inner.slopeAbove);
+			return true;
+		} else if (inner.isAffine()) {
+			//the kink of outer moves to the value that inner maps onto it
+			result = PiecewiseLinear(inner.inverse()(outer.pivot), outer.pivotValue, outer.slopeBelow*inner.slopeAbove, outer.slopeAbove*inner.slopeAbove);
+			return true;
+		} else if (inner.pivotValue == outer.pivot) {
+			//both kinks are at the same position
+			result = PiecewiseLinear(inner.pivot, outer.pivotValue, outer.slopeBelow*inner.slopeBelow, outer.slopeAbove*inner.slopeAbove);
+			return true;
+		}
+		return false;
+	}
+}
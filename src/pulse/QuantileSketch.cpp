@@ -0,0 +1,467 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/QuantileSketch.h>
+#include "ScalingHelpers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace pulse {
+	namespace {
+		using detail::StridedAccessor;
+		using detail::RowAccessor;
+		
+		/** True if value is an integer in [min, max] */
+		bool isCount(double value, double min, double max) {
+			return value >= min && value <= max && value == std::floor(value);
+		}
+		
+		/** splitmix64, used to choose the sampled values */
+		inline unsigned long long hash(unsigned long long x) {
+			x += 0x9e3779b97f4a7c15ULL;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+			return x ^ (x >> 31);
+		}
+	}
+	
+	QuantileSketch::QuantileSketch(size_t k) :
+		m_k(k),
+		m_levels(1),
+		m_size(0),
+		m_capacity(0),
+		m_count(0),
+		m_compactions(0),
+		m_sampleLevel(0),
+		m_blockFill(0),
+		m_blockPick(0),
+		m_numBlocks(0),
+		m_min(0.0),
+		m_max(0.0)
+	{
+		assert(k >= 8);
+		updateCapacity();
+	}
+	size_t QuantileSketch::getLevelCapacity(size_t h) const {
+		//the top level has capacity k, every level below 2/3 of the one above
+		const size_t depth = m_levels.size() - 1 - h;
+		const size_t re = static_cast<size_t>(ceil(m_k*pow(2.0/3.0, static_cast<double>(depth))));
+		return (re > minLevelCapacity) ? re : minLevelCapacity;
+	}
+	inline size_t QuantileSketch::getCapacity(size_t h) const {
+		return m_capacities[h];
+	}
+	void QuantileSketch::updateCapacity() {
+		m_capacities.resize(m_levels.size());
+		m_capacity = 0;
+		for (size_t h = 0; h < m_levels.size(); h++) {
+			m_capacities[h] = getLevelCapacity(h);
+			m_capacity += m_capacities[h];
+		}
+	}
+	void QuantileSketch::compact(size_t h) {
+		if (h+1 == m_levels.size()) {
+			m_levels.push_back(std::vector<double>());
+			updateCapacity();
+		}
+		std::vector<double>& level = m_levels[h];
+		std::vector<double>& next = m_levels[h+1];
+		std::sort(level.begin(), level.end());
+		//an odd value stays on this level
+		const size_t first = level.size() % 2;
+		const size_t offset = static_cast<size_t>(m_compactions++ % 2);
+		for (size_t i = first + offset; i < level.size(); i += 2) {
+			next.push_back(level[i]);
+		}
+		const size_t numCompacted = level.size() - first;
+		level.resize(first);
+		m_size -= numCompacted/2;
+	}
+	void QuantileSketch::increaseSampleLevel() {
+		compact(0);
+		if (!m_levels[0].empty()) {
+			//the odd value moves up with probability 1/2
+			if (hash(m_compactions) & 1) {
+				m_levels[1].push_back(m_levels[0][0]);
+			} else {
+				m_size--;
+			}
+		}
+		m_levels.erase(m_levels.begin());
+		m_sampleLevel++;
+		updateCapacity();
+		nextBlock();
+	}
+	void QuantileSketch::nextBlock() {
+		m_blockFill = 0;
+		m_blockPick = static_cast<size_t>(hash(m_numBlocks++) & ((static_cast<unsigned long long>(1) << m_sampleLevel) - 1));
+	}
+	void QuantileSketch::compress() {
+		while (m_size >= m_capacity) {
+			//there is always a level at its capacity if the sketch is full
+			size_t h = 0;
+			while (m_levels[h].size() < getCapacity(h)) {
+				h++;
+			}
+			compact(h);
+		}
+		//sampling replaces level 0 once level 1 is at the minimal capacity as well
+		while (m_levels.size() > 2 && getLevelCapacity(1) <= minLevelCapacity) {
+			increaseSampleLevel();
+		}
+	}
+	template<class Accessor>
+	void QuantileSketch::addBatch(const Accessor& data, size_t num) {
+		//exact count, minimum and maximum
+		for (size_t i = 0; i < num; i++) {
+			const double value = data(i);
+			if (value == value) {
+				if (m_count == 0) {
+					m_min = value;
+					m_max = value;
+				}
+				m_min = std::min(m_min, value);
+				m_max = std::max(m_max, value);
+				m_count++;
+			}
+		}
+		size_t i = 0;
+		while (i < num) {
+			if (m_size >= m_capacity) {
+				compress();
+			}
+			//fill the free space of the sketch
+			std::vector<double>& level = m_levels[0];
+			const size_t numBefore = level.size();
+			const size_t numFree = m_capacity - m_size;
+			if (m_sampleLevel == 0) {
+				const size_t end = std::min(num, i + numFree);
+				for (; i < end; i++) {
+					const double value = data(i);
+					if (value == value) {
+						level.push_back(value);
+					}
+				}
+			} else {
+				//only the picked value of every block is read
+				const size_t blockSize = static_cast<size_t>(1) << m_sampleLevel;
+				while (i < num && level.size() - numBefore < numFree) {
+					const size_t take = std::min(blockSize - m_blockFill, num - i);
+					if (m_blockFill <= m_blockPick && m_blockPick < m_blockFill + take) {
+						const double value = data(i + m_blockPick - m_blockFill);
+						if (value == value) {
+							level.push_back(value);
+						}
+					}
+					i += take;
+					m_blockFill += take;
+					if (m_blockFill == blockSize) {
+						nextBlock();
+					}
+				}
+			}
+			m_size += level.size() - numBefore;
+		}
+		if (m_size >= m_capacity) {
+			compress();
+		}
+	}
+	bool QuantileSketch::add(double value) {
+		if (value != value) {
+			return false;
+		}
+		if (m_count == 0) {
+			m_min = value;
+			m_max = value;
+		}
+		m_min = std::min(m_min, value);
+		m_max = std::max(m_max, value);
+		m_count++;
+		if (m_sampleLevel > 0) {
+			const bool picked = (m_blockFill == m_blockPick);
+			if (++m_blockFill == (static_cast<size_t>(1) << m_sampleLevel)) {
+				nextBlock();
+			}
+			if (!picked) {
+				return false;
+			}
+		}
+		m_levels[0].push_back(value);
+		m_size++;
+		if (m_size >= m_capacity) {
+			compress();
+			return true;
+		}
+		return false;
+	}
+	bool QuantileSketch::add(double value, unsigned long long num) {
+		if (value != value || num == 0) {
+			return false;
+		}
+		if (m_count == 0) {
+			m_min = value;
+			m_max = value;
+		}
+		m_min = std::min(m_min, value);
+		m_max = std::max(m_max, value);
+		m_count += num;
+		const unsigned long long blockSize = static_cast<unsigned long long>(1) << m_sampleLevel;
+		//the rest of the current block
+		if (m_blockFill > 0) {
+			const unsigned long long take = std::min(blockSize - m_blockFill, num);
+			if (m_blockFill <= m_blockPick && m_blockPick < m_blockFill + take) {
+				m_levels[0].push_back(value);
+				m_size++;
+			}
+			m_blockFill += static_cast<size_t>(take);
+			num -= take;
+			if (m_blockFill == blockSize) {
+				nextBlock();
+			}
+		}
+		//the complete blocks, a value on level h stands for 2^h blocks
+		const unsigned long long numBlocks = num >> m_sampleLevel;
+		unsigned long long bits = numBlocks;
+		for (size_t h = 0; bits > 0; h++, bits >>= 1) {
+			if (bits & 1) {
+				if (h >= m_levels.size()) {
+					m_levels.resize(h+1);
+					updateCapacity();
+				}
+				m_levels[h].push_back(value);
+				m_size++;
+			}
+		}
+		if (m_sampleLevel > 0) {
+			if (numBlocks > 0) {
+				m_numBlocks += numBlocks - 1;
+				nextBlock();
+			}
+			//the begin of the next block
+			const size_t tail = static_cast<size_t>(num & (blockSize - 1));
+			if (m_blockPick < tail) {
+				m_levels[0].push_back(value);
+				m_size++;
+			}
+			m_blockFill = tail;
+		}
+		if (m_size >= m_capacity) {
+			compress();
+			return true;
+		}
+		return false;
+	}
+	void QuantileSketch::add(double const* data, size_t offset, size_t num) {
+		addBatch(StridedAccessor(data, offset), num);
+	}
+	void QuantileSketch::add(double** const data, size_t offset, size_t num) {
+		addBatch(RowAccessor(data, offset), num);
+	}
+	void QuantileSketch::merge(const QuantileSketch& other) {
+		if (other.m_k != m_k) {
+			throw MergeException("QuantileSketches with different k can not be merged");
+		}
+		if (other.m_count == 0) {
+			return;
+		}
+		if (m_count == 0) {
+			m_min = other.m_min;
+			m_max = other.m_max;
+		}
+		m_min = std::min(m_min, other.m_min);
+		m_max = std::max(m_max, other.m_max);
+		//the levels of both sketches need the same weights
+		while (m_sampleLevel < other.m_sampleLevel) {
+			increaseSampleLevel();
+		}
+		QuantileSketch aligned(other);
+		while (aligned.m_sampleLevel < m_sampleLevel) {
+			aligned.increaseSampleLevel();
+		}
+		if (aligned.m_levels.size() > m_levels.size()) {
+			m_levels.resize(aligned.m_levels.size());
+			updateCapacity();
+		}
+		for (size_t h = 0; h < aligned.m_levels.size(); h++) {
+			m_levels[h].insert(m_levels[h].end(), aligned.m_levels[h].begin(), aligned.m_levels[h].end());
+		}
+		m_size += aligned.m_size;
+		m_count += other.m_count;
+		m_compactions += aligned.m_compactions;
+		compress();
+	}
+	void QuantileSketch::clear() {
+		m_levels.clear();
+		m_levels.resize(1);
+		m_size = 0;
+		m_count = 0;
+		m_compactions = 0;
+		m_sampleLevel = 0;
+		m_blockFill = 0;
+		m_blockPick = 0;
+		m_numBlocks = 0;
+		m_min = 0.0;
+		m_max = 0.0;
+		updateCapacity();
+	}
+	double QuantileSketch::getQuantile(double q) const {
+		double re;
+		getQuantiles(&q, 1, &re);
+		return re;
+	}
+	void QuantileSketch::getQuantiles(const double* q, size_t num, double* re) const {
+		assert(m_count > 0);
+		//values with their weights, sorted by value
+		std::vector<std::pair<double, double> > items;
+		items.reserve(m_size);
+		double weight = ldexp(1.0, static_cast<int>(m_sampleLevel));
+		double total = 0.0;
+		for (size_t h = 0; h < m_levels.size(); h++) {
+			for (size_t i = 0; i < m_levels[h].size(); i++) {
+				items.push_back(std::make_pair(m_levels[h][i], weight));
+			}
+			total += weight*m_levels[h].size();
+			weight *= 2.0;
+		}
+		std::sort(items.begin(), items.end());
+		size_t j = 0;
+		double rank = items.empty() ? total : items[0].second;
+		for (size_t i = 0; i < num; i++) {
+			assert(q[i] >= 0.0 && q[i] <= 1.0);
+			assert(i == 0 || q[i-1] <= q[i]);
+			if (q[i] <= 0.0 || items.empty()) {
+				re[i] = (q[i] < 0.5) ? m_min : m_max;
+			} else if (q[i] >= 1.0) {
+				re[i] = m_max;
+			} else {
+				const double target = q[i]*total;
+				while (rank < target && j+1 < items.size()) {
+					j++;
+					rank += items[j].second;
+				}
+				re[i] = items[j].first;
+			}
+		}
+	}
+	unsigned long long QuantileSketch::getCount() const {
+		return m_count;
+	}
+	size_t QuantileSketch::getNumRetained() const {
+		return m_size;
+	}
+	size_t QuantileSketch::getK() const {
+		return m_k;
+	}
+	void QuantileSketch::getParameters(std::vector<double>& params) const {
+		params.push_back(static_cast<double>(m_k));
+		params.push_back(static_cast<double>(m_compactions));
+		params.push_back(static_cast<double>(m_count));
+		params.push_back(m_min);
+		params.push_back(m_max);
+		params.push_back(static_cast<double>(m_sampleLevel));
+		params.push_back(static_cast<double>(m_blockFill));
+		params.push_back(static_cast<double>(m_blockPick));
+		params.push_back(static_cast<double>(m_numBlocks));
+		params.push_back(static_cast<double>(m_levels.size()));
+		for (size_t h = 0; h < m_levels.size(); h++) {
+			params.push_back(static_cast<double>(m_levels[h].size()));
+			params.insert(params.end(), m_levels[h].begin(), m_levels[h].end());
+		}
+	}
+	size_t QuantileSketch::setParameters(const std::vector<double>& params, size_t first) {
+		assert(params.size() >= first + numHeaderParameters);
+		size_t i = first;
+		m_k = static_cast<size_t>(params[i++]);
+		assert(m_k >= 8);
+		m_compactions = static_cast<unsigned long long>(params[i++]);
+		m_count = static_cast<unsigned long long>(params[i++]);
+		m_min = params[i++];
+		m_max = params[i++];
+		m_sampleLevel = static_cast<size_t>(params[i++]);
+		m_blockFill = static_cast<size_t>(params[i++]);
+		m_blockPick = static_cast<size_t>(params[i++]);
+		m_numBlocks = static_cast<unsigned long long>(params[i++]);
+		assert(m_sampleLevel < 63);
+		const size_t numLevels = static_cast<size_t>(params[i++]);
+		assert(numLevels > 0);
+		m_levels.clear();
+		m_levels.resize(numLevels);
+		m_size = 0;
+		for (size_t h = 0; h < numLevels; h++) {
+			assert(i < params.size());
+			const size_t size = static_cast<size_t>(params[i++]);
+			assert(i + size <= params.size());
+			m_levels[h].assign(params.begin() + i, params.begin() + i + size);
+			m_size += size;
+			i += size;
+		}
+		updateCapacity();
+		compress();
+		return i;
+	}
+	bool QuantileSketch::checkParameters(const std::vector<double>& params, size_t first, size_t& end) {
+		if (params.size() < first + numHeaderParameters) {
+			return false;
+		}
+		//k, compactions, count, min, max, sample level, block fill, block pick, number of blocks
+		const double maxCount = 1.8e19;
+		if (!isCount(params[first], 8.0, 1e9) || !isCount(params[first + 1], 0.0, maxCount) || !isCount(params[first + 2], 0.0, maxCount)) {
+			return false;
+		}
+		if (!isCount(params[first + 5], 0.0, 62.0)) {
+			return false;
+		}
+		const double blockSize = ldexp(1.0, static_cast<int>(params[first + 5]));
+		if (!isCount(params[first + 6], 0.0, blockSize - 1.0) || !isCount(params[first + 7], 0.0, blockSize - 1.0) || !isCount(params[first + 8], 0.0, maxCount)) {
+			return false;
+		}
+		size_t i = first + 9;
+		//every level has at least its size
+		const double numLevels = params[i++];
+		if (!isCount(numLevels, 1.0, static_cast<double>(params.size() - i))) {
+			return false;
+		}
+		for (size_t h = 0; h < static_cast<size_t>(numLevels); h++) {
+			if (i >= params.size() || !isCount(params[i], 0.0, static_cast<double>(params.size() - i - 1))) {
+				return false;
+			}
+			i += 1 + static_cast<size_t>(params[i]);
+		}
+		end = i;
+		return true;
+	}
+}
@@ -0,0 +1,288 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/QuantileTransform.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace pulse {
+	namespace {
+		using detail::StridedAccessor;
+		using detail::StridedOutput;
+		using detail::RowAccessor;
+		
+		/** Number of values that are searched together */
+		const size_t blockSize = 8;
+		/** Number of inner knots in a group of the two stage search */
+		const size_t groupSize = 8;
+	}
+	
+	std::string QuantileTransform::m_name = std::string("QuantileTransform");
+	
+	QuantileTransform::QuantileTransform(double minNorm, double maxNorm, size_t numKnots, size_t sketchSize) :
+		m_sketch(sketchSize),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm),
+		m_step(0.0),
+		m_knots(numKnots)
+	{
+		assert(minNorm < maxNorm);
+		assert(numKnots >= 2);
+		for (size_t i = 0; i < numKnots; i++) {
+			m_knots[i] = static_cast<double>(i)/(numKnots-1);
+		}
+		updateSegments();
+	}
+	void QuantileTransform::updateKnots() {
+		if (m_sketch.getCount() == 0) {
+			//only NaNs so far, keep the old knots
+			return;
+		}
+		const size_t numKnots = m_knots.size();
+		std::vector<double> q(numKnots);
+		for (size_t i = 0; i < numKnots; i++) {
+			q[i] = static_cast<double>(i)/(numKnots-1);
+		}
+		m_sketch.getQuantiles(&q[0], numKnots, &m_knots[0]);
+		updateSegments();
+	}
+	void QuantileTransform::updateSegments() {
+		const size_t numKnots = m_knots.size();
+		//make sure that the first knot is smaller than the last one (same as Normalize)
+		if (m_knots[numKnots-1] - m_knots[0] == 0.0) {
+			const double min = m_knots[0];
+			const double max = min + min*min + 1.0;
+			for (size_t i = 1; i < numKnots; i++) {
+				m_knots[i] = min + (max-min)*i/(numKnots-1);
+			}
+		}
+		m_step = (m_maxNorm-m_minNorm)/(numKnots-1);
+		m_segmentValue.resize(numKnots-1);
+		m_slope.resize(numKnots-1);
+		m_inverseSlope.resize(numKnots-1);
+		for (size_t i = 0; i+1 < numKnots; i++) {
+			const double width = m_knots[i+1] - m_knots[i];
+			m_segmentValue[i] = m_minNorm + m_step*i;
+			//segments of repeated knots are only reached by values on the knot
+			m_slope[i] = (width > 0.0) ? m_step/width : 0.0;
+			m_inverseSlope[i] = width/m_step;
+		}
+		//inner knots padded to full groups, the padding is never counted
+		const size_t numInner = numKnots-2;
+		const size_t numGroups = (numInner + groupSize - 1)/groupSize;
+		m_searchKnots.assign(numGroups*groupSize, std::numeric_limits<double>::infinity());
+		for (size_t i = 0; i < numInner; i++) {
+			m_searchKnots[i] = m_knots[i+1];
+		}
+		//first knot of every group except the first one
+		m_groupKnots.resize(numGroups > 0 ? numGroups-1 : 0);
+		for (size_t g = 1; g < numGroups; g++) {
+			m_groupKnots[g-1] = m_searchKnots[g*groupSize];
+		}
+	}
+	inline size_t QuantileTransform::findSegment(double value) const {
+		//number of inner knots that are not bigger than value, first the group then within the group
+		const size_t numGroupKnots = m_groupKnots.size();
+		size_t group = 0;
+		for (size_t g = 0; g < numGroupKnots; g++) {
+			group += (m_groupKnots[g] <= value) ? 1 : 0;
+		}
+		if (m_searchKnots.empty()) {
+			return 0;
+		}
+		const double* knots = &m_searchKnots[group*groupSize];
+		size_t re = group*groupSize;
+		for (size_t k = 0; k < groupSize; k++) {
+			re += (knots[k] <= value) ? 1 : 0;
+		}
+		return re;
+	}
+	template<class Input, class Output>
+	void QuantileTransform::transform(const Input& in, const Output& out, size_t num) const {
+		const double* knots = &m_knots[0];
+		const double* segmentValue = &m_segmentValue[0];
+		const double* slope = &m_slope[0];
+		const double* groupKnots = m_groupKnots.empty() ? 0 : &m_groupKnots[0];
+		const double* searchKnots = m_searchKnots.empty() ? 0 : &m_searchKnots[0];
+		const size_t numGroupKnots = m_groupKnots.size();
+		size_t i = 0;
+		for (; searchKnots != 0 && i + blockSize <= num; i += blockSize) {
+			double values[blockSize];
+			long group[blockSize];
+			for (size_t b = 0; b < blockSize; b++) {
+				values[b] = in(i+b);
+				group[b] = 0;
+			}
+			//compare every value of the block with the first knot of every group and count, without branches
+			for (size_t g = 0; g < numGroupKnots; g++) {
+				const double knot = groupKnots[g];
+				for (size_t b = 0; b < blockSize; b++) {
+					group[b] += (knot <= values[b]) ? 1 : 0;
+				}
+			}
+			for (size_t b = 0; b < blockSize; b++) {
+				//compare with all knots of the group
+				const double* groupStart = searchKnots + group[b]*groupSize;
+				long s = group[b]*groupSize;
+				for (size_t k = 0; k < groupSize; k++) {
+					s += (groupStart[k] <= values[b]) ? 1 : 0;
+				}
+				out(i+b) = segmentValue[s] + (values[b]-knots[s])*slope[s];
+			}
+		}
+		for (; i < num; i++) {
+			const double value = in(i);
+			const size_t s = findSegment(value);
+			out(i) = segmentValue[s] + (value-knots[s])*slope[s];
+		}
+	}
+	void QuantileTransform::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.add(data, offset, num);
+		updateKnots();
+	}
+	void QuantileTransform::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		m_sketch.add(data, offset, num);
+		updateKnots();
+	}
+	void QuantileTransform::updateScalingFactors(double value) {
+		const bool compacted = m_sketch.add(value);
+		const unsigned long long count = m_sketch.getCount();
+		if (compacted || (count & (count-1)) == 0) {
+			updateKnots();
+		}
+	}
+	void QuantileTransform::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		m_sketch.add(value, static_cast<unsigned long long>(num));
+		updateKnots();
+	}
+	void QuantileTransform::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.clear();
+		updateScalingFactors(data, offset, num);
+	}
+	void QuantileTransform::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.clear();
+		updateScalingFactors(data, offset, num);
+	}
+	void QuantileTransform::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		transform(StridedAccessor(in, inOffset), StridedOutput(out, outOffset), num);
+	}
+	void QuantileTransform::scale(double** data, size_t offset, size_t num) const {
+		transform(RowAccessor(data, offset), RowAccessor(data, offset), num);
+	}
+	double QuantileTransform::scale(double value) const {
+		const size_t s = findSegment(value);
+		return m_segmentValue[s] + (value-m_knots[s])*m_slope[s];
+	}
+	double QuantileTransform::originalValue(double value) const {
+		//the scaled values of the knots are evenly spaced
+		const double position = floor((value-m_minNorm)/m_step);
+		const double last = static_cast<double>(m_knots.size()-2);
+		const size_t s = static_cast<size_t>(position < 0.0 ? 0.0 : (position > last ? last : position));
+		return m_knots[s] + (value-m_segmentValue[s])*m_inverseSlope[s];
+	}
+	bool QuantileTransform::getPiecewiseLinear(PiecewiseLinear& function) const {
+		if (m_knots.size() != 2) {
+			return false;
+		}
+		function = PiecewiseLinear(m_knots[0], m_minNorm, m_slope[0], m_slope[0]);
+		return true;
+	}
+	bool QuantileTransform::getNormRange(double& minNorm, double& maxNorm) const {
+		minNorm = m_minNorm;
+		maxNorm = m_maxNorm;
+		return true;
+	}
+	void QuantileTransform::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_minNorm);
+		params.push_back(m_maxNorm);
+		params.push_back(static_cast<double>(m_knots.size()));
+		params.insert(params.end(), m_knots.begin(), m_knots.end());
+		m_sketch.getParameters(params);
+	}
+	void QuantileTransform::setParameters(const std::vector<double>& params) {
+		assert(params.size() > 3);
+		m_minNorm = params[0];
+		m_maxNorm = params[1];
+		assert(m_minNorm < m_maxNorm);
+		const size_t numKnots = static_cast<size_t>(params[2]);
+		assert(numKnots >= 2);
+		assert(params.size() >= 3 + numKnots);
+		m_knots.assign(params.begin() + 3, params.begin() + 3 + numKnots);
+		const size_t end = m_sketch.setParameters(params, 3 + numKnots);
+		assert(end == params.size());
+		(void)end;
+		//the saved knots are used as they are, they are only fitted again by the next update
+		updateSegments();
+	}
+	bool QuantileTransform::checkParameters(const std::vector<double>& params) {
+		if (params.size() <= 3 || !(params[0] < params[1])) {
+			return false;
+		}
+		const double numKnots = params[2];
+		if (!(numKnots >= 2.0 && numKnots <= static_cast<double>(params.size() - 3) && numKnots == std::floor(numKnots))) {
+			return false;
+		}
+		size_t end = 0;
+		return QuantileSketch::checkParameters(params, 3 + static_cast<size_t>(numKnots), end) && end == params.size();
+	}
+	const std::string& QuantileTransform::getTypeName() const {
+		return m_name;
+	}
+	Scaler* QuantileTransform::clone() const {
+		return new QuantileTransform(*this);
+	}
+	void QuantileTransform::merge(const Scaler& other) {
+		checkMergeable(other);
+		const QuantileTransform& o = static_cast<const QuantileTransform&>(other);
+		if (o.m_knots.size() != m_knots.size() || o.m_sketch.getK() != m_sketch.getK()) {
+			throw MergeException("QuantileTransform scalers with different numbers of knots or sketch sizes can not be merged");
+		}
+		m_sketch.merge(o.m_sketch);
+		updateKnots();
+	}
+	const std::vector<double>& QuantileTransform::getKnots() const {
+		return m_knots;
+	}
+	const QuantileSketch& QuantileTransform::getSketch() const {
+		return m_sketch;
+	}
+}
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/RobustNormalize.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace pulse {
+	std::string RobustNormalize::m_name = std::string("RobustNormalize");
+	
+	RobustNormalize::RobustNormalize(double minNorm, double maxNorm, double lowerQuantile, double upperQuantile, bool clip, size_t sketchSize) :
+		m_sketch(sketchSize),
+		m_lowerQuantile(lowerQuantile),
+		m_upperQuantile(upperQuantile),
+		m_lower(0.0),
+		m_upper(1.0),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm),
+		m_clip(clip)
+	{
+		assert(minNorm < maxNorm);
+		assert(0.0 <= lowerQuantile && lowerQuantile < upperQuantile && upperQuantile <= 1.0);
+	}
+	void RobustNormalize::updateRange() {
+		if (m_sketch.getCount() == 0) {
+			//only NaNs so far, keep the old range
+			return;
+		}
+		const double q[2] = {m_lowerQuantile, m_upperQuantile};
+		double range[2];
+		m_sketch.getQuantiles(q, 2, range);
+		m_lower = range[0];
+		m_upper = range[1];
+		//make sure that m_lower < m_upper (same as Normalize)
+		if (m_upper - m_lower == 0.0) {
+			m_upper = m_upper + m_upper*m_upper + 1.0;
+		}
+	}
+	void RobustNormalize::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.add(data, offset, num);
+		updateRange();
+	}
+	void RobustNormalize::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		m_sketch.add(data, offset, num);
+		updateRange();
+	}
+	void RobustNormalize::updateScalingFactors(double value) {
+		const bool compacted = m_sketch.add(value);
+		const unsigned long long count = m_sketch.getCount();
+		if (compacted || (count & (count-1)) == 0) {
+			updateRange();
+		}
+	}
+	void RobustNormalize::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		m_sketch.add(value, static_cast<unsigned long long>(num));
+		updateRange();
+	}
+	void RobustNormalize::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.clear();
+		updateScalingFactors(data, offset, num);
+	}
+	void RobustNormalize::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_sketch.clear();
+		updateScalingFactors(data, offset, num);
+	}
+	void RobustNormalize::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		const double factor = (m_maxNorm-m_minNorm)/(m_upper-m_lower);
+		const double lower = m_lower;
+		const double minNorm = m_minNorm;
+		const double maxNorm = m_maxNorm;
+		if (m_clip) {
+			//min/max instead of branches, NaNs are kept
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = std::min(std::max((in[i*inOffset]-lower)*factor + minNorm, minNorm), maxNorm);
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = (in[i*inOffset]-lower)*factor + minNorm;
+			}
+		}
+	}
+	void RobustNormalize::scale(double** data, size_t offset, size_t num) const {
+		const double factor = (m_maxNorm-m_minNorm)/(m_upper-m_lower);
+		const double lower = m_lower;
+		const double minNorm = m_minNorm;
+		const double maxNorm = m_maxNorm;
+		if (m_clip) {
+			for (size_t i = 0; i < num; i++) {
+				data[i][offset] = std::min(std::max((data[i][offset]-lower)*factor + minNorm, minNorm), maxNorm);
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				data[i][offset] = (data[i][offset]-lower)*factor + minNorm;
+			}
+		}
+	}
+	double RobustNormalize::scale(double value) const {
+		const double re = ((value-m_lower)/(m_upper-m_lower))*(m_maxNorm-m_minNorm)+m_minNorm;
+		if (m_clip) {
+			return std::min(std::max(re, m_minNorm), m_maxNorm);
+		}
+		return re;
+	}
+	double RobustNormalize::originalValue(double value) const {
+		return ((value - m_minNorm)/(m_maxNorm-m_minNorm))*(m_upper-m_lower) + m_lower;
+	}
+	bool RobustNormalize::getPiecewiseLinear(PiecewiseLinear& function) const {
+		if (m_clip) {
+			return false;
+		}
+		const double slope = (m_maxNorm-m_minNorm)/(m_upper-m_lower);
+		function = PiecewiseLinear(m_lower, m_minNorm, slope, slope);
+		return true;
+	}
+	bool RobustNormalize::getNormRange(double& minNorm, double& maxNorm) const {
+		minNorm = m_minNorm;
+		maxNorm = m_maxNorm;
+		return true;
+	}
+	void RobustNormalize::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_lowerQuantile);
+		params.push_back(m_upperQuantile);
+		params.push_back(m_minNorm);
+		params.push_back(m_maxNorm);
+		params.push_back(m_clip ? 1.0 : 0.0);
+		m_sketch.getParameters(params);
+	}
+	void RobustNormalize::setParameters(const std::vector<double>& params) {
+		assert(params.size() > 5);
+		m_lowerQuantile = params[0];
+		m_upperQuantile = params[1];
+		m_minNorm = params[2];
+		m_maxNorm = params[3];
+		m_clip = (params[4] != 0.0);
+		assert(0.0 <= m_lowerQuantile && m_lowerQuantile < m_upperQuantile && m_upperQuantile <= 1.0);
+		assert(m_minNorm < m_maxNorm);
+		const size_t end = m_sketch.setParameters(params, 5);
+		assert(end == params.size());
+		(void)end;
+		updateRange();
+	}
+	bool RobustNormalize::checkParameters(const std::vector<double>& params) {
+		if (params.size() <= 5) {
+			return false;
+		}
+		if (!(0.0 <= params[0] && params[0] < params[1] && params[1] <= 1.0) || !(params[2] < params[3])) {
+			return false;
+		}
+		size_t end = 0;
+		return QuantileSketch::checkParameters(params, 5, end) && end == params.size();
+	}
+	const std::string& RobustNormalize::getTypeName() const {
+		return m_name;
+	}
+	Scaler* RobustNormalize::clone() const {
+		return new RobustNormalize(*this);
+	}
+	void RobustNormalize::merge(const Scaler& other) {
+		checkMergeable(other);
+		const RobustNormalize& o = static_cast<const RobustNormalize&>(other);
+		if (o.m_lowerQuantile != m_lowerQuantile || o.m_upperQuantile != m_upperQuantile || o.m_clip != m_clip || o.m_sketch.getK() != m_sketch.getK()) {
+			throw MergeException("RobustNormalize scalers with different quantiles, clipping or sketch sizes can not be merged");
+		}
+		m_sketch.merge(o.m_sketch);
+		updateRange();
+	}
+	double RobustNormalize::getLower() const {
+		return m_lower;
+	}
+	double RobustNormalize::getUpper() const {
+		return m_upper;
+	}
+	const QuantileSketch& RobustNormalize::getSketch() const {
+		return m_sketch;
+	}
+}
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Scaler.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+
+namespace pulse {
+	namespace {
+		using detail::imputeMissing;
+		using detail::isMissing;
+		
+		/** Evaluates function in single precision */
+		void applyInFloat(const PiecewiseLinear& function, float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) {
+			const float pivot = static_cast<float>(function.pivot);
+			const float pivotValue = static_cast<float>(function.pivotValue);
+			const float slopeBelow = static_cast<float>(function.slopeBelow);
+			const float slopeAbove = static_cast<float>(function.slopeAbove);
+			for (size_t i = 0; i < num; i++) {
+				const float d = in[i*inOffset] - pivot;
+				out[i*outOffset] = pivotValue + d*(d < 0.0f ? slopeBelow : slopeAbove);
+			}
+		}
+		/** Evaluates function in single precision and replaces the results of missing values by imputed, see ImputeMissing */
+		void applyInFloat(const PiecewiseLinear& function, float imputed, float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) {
+			const float pivot = static_cast<float>(function.pivot);
+			const float pivotValue = static_cast<float>(function.pivotValue);
+			const float slopeBelow = static_cast<float>(function.slopeBelow);
+			const float slopeAbove = static_cast<float>(function.slopeAbove);
+			for (size_t i = 0; i < num; i++) {
+				const float value = in[i*inOffset];
+				const float d = value - pivot;
+				out[i*outOffset] = imputeMissing(value, pivotValue + d*(d < 0.0f ? slopeBelow : slopeAbove), imputed);
+			}
+		}
+	}
+	
+#ifdef __APPLE__
+#pragma mark Updating of the scaler paramters
+#endif
+	/** \name Updating of the scaler paramters
+	 @{ */
+	void Scaler::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		if (isExtremaSufficient() && !isMissing(value)) {
+			//the copies do not change the extrema
+			updateScalingFactors(value);
+			return;
+		}
+		//with a stride of 0 the same value is read num times
+		updateScalingFactors(&value, 0, num);
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#endif
+#ifdef __APPLE__
+#pragma mark Single precision scaling
+#endif
+	/** \name Single precision scaling
+	 @{ */
+	void Scaler::scaleFloats(float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const {
+		PiecewiseLinear function;
+		double imputed;
+		if (getPiecewiseLinear(function)) {
+			if (getMissingValuePolicy(imputed) == ImputeMissing) {
+				applyInFloat(function, static_cast<float>(imputed), in, inOffset, out, outOffset, num);
+			} else {
+				applyInFloat(function, in, inOffset, out, outOffset, num);
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = static_cast<float>(scale(static_cast<double>(in[i*inOffset])));
+			}
+		}
+	}
+	void Scaler::scaleToFloats(double const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const {
+		PiecewiseLinear function;
+		double imputed;
+		if (getPiecewiseLinear(function)) {
+			if (getMissingValuePolicy(imputed) == ImputeMissing) {
+				for (size_t i = 0; i < num; i++) {
+					const double value = in[i*inOffset];
+					out[i*outOffset] = static_cast<float>(imputeMissing(value, function(value), imputed));
+				}
+			} else {
+				for (size_t i = 0; i < num; i++) {
+					out[i*outOffset] = static_cast<float>(function(in[i*inOffset]));
+				}
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = static_cast<float>(scale(in[i*inOffset]));
+			}
+		}
+	}
+	void Scaler::originalFloatValues(float const* in, size_t inOffset, float* out, size_t outOffset, size_t num) const {
+		PiecewiseLinear function;
+		if (getPiecewiseLinear(function)) {
+			applyInFloat(function.inverse(), in, inOffset, out, outOffset, num);
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = static_cast<float>(originalValue(static_cast<double>(in[i*inOffset])));
+			}
+		}
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#pragma mark Rescaling of scaled data
+#endif
+	/** \name Rescaling of scaled data
+	 @{ */
+	void Scaler::rescale(const Scaler& previous, double* data, size_t offset, size_t num) const {
+		PiecewiseLinear function;
+		double imputed;
+		if (getRescaling(previous, function)) {
+			if (getMissingValuePolicy(imputed) == ImputeMissing) {
+				for (size_t i = 0; i < num; i++) {
+					const double value = data[i*offset];
+					data[i*offset] = imputeMissing(value, function(value), imputed);
+				}
+			} else {
+				for (size_t i = 0; i < num; i++) {
+					data[i*offset] = function(data[i*offset]);
+				}
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				data[i*offset] = scale(previous.originalValue(data[i*offset]));
+			}
+		}
+	}
+	void Scaler::rescale(const Scaler& previous, double** data, size_t offset, size_t num) const {
+		PiecewiseLinear function;
+		double imputed;
+		if (getRescaling(previous, function)) {
+			if (getMissingValuePolicy(imputed) == ImputeMissing) {
+				for (size_t i = 0; i < num; i++) {
+					const double value = data[i][offset];
+					data[i][offset] = imputeMissing(value, function(value), imputed);
+				}
+			} else {
+				for (size_t i = 0; i < num; i++) {
+					data[i][offset] = function(data[i][offset]);
+				}
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				data[i][offset] = scale(previous.originalValue(data[i][offset]));
+			}
+		}
+	}
+	bool Scaler::getRescaling(const Scaler& previous, PiecewiseLinear& function) const {
+		PiecewiseLinear current;
+		PiecewiseLinear old;
+		if (!getPiecewiseLinear(current) || !previous.getPiecewiseLinear(old)) {
+			return false;
+		}
+		return PiecewiseLinear::compose(current, old.inverse(), function);
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#endif
+#ifdef __APPLE__
+#pragma mark Merging of fitted scalers
+#endif
+	/** \name Merging of fitted scalers
+	 @{ */
+	void Scaler::merge(const Scaler& /*other*/) {
+		throw MergeException(getTypeName() + " can not be merged");
+	}
+	void Scaler::checkMergeable(const Scaler& other) const {
+		if (other.getTypeName() != getTypeName()) {
+			throw MergeException("can not merge " + other.getTypeName() + " into " + getTypeName());
+		}
+		double minNorm[2];
+		double maxNorm[2];
+		const bool hasRange = getNormRange(minNorm[0], maxNorm[0]);
+		if (hasRange != other.getNormRange(minNorm[1], maxNorm[1]) || (hasRange && (minNorm[0] != minNorm[1] || maxNorm[0] != maxNorm[1]))) {
+			throw MergeException(getTypeName() + " scalers with different norm ranges can not be merged");
+		}
+	}
+	/*@}*/
+#ifdef __APPLE__
+#pragma mark -
+#endif
+}
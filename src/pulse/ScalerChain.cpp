@@ -0,0 +1,373 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <pulse/ScalerChain.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+
+namespace pulse {
+	namespace {
+		using detail::imputeMissing;
+	}
+	
+	std::string ScalerChain::m_name = std::string("ScalerChain");
+	
+	ScalerChain::ScalerChain() {
+		
+	}
+	ScalerChain::ScalerChain(const ScalerChain& other) {
+		*this = other;
+	}
+	ScalerChain& ScalerChain::operator=(const ScalerChain& other) {
+		if (this != &other) {
+			clear();
+			std::vector<Scaler*>::const_iterator it;
+			for (it = other.m_scalers.begin(); it != other.m_scalers.end(); it++) {
+				m_scalers.push_back((*it)->clone());
+			}
+			updateStages();
+		}
+		return *this;
+	}
+	ScalerChain::~ScalerChain() {
+		clear();
+	}
+	void ScalerChain::clear() {
+		std::vector<Scaler*>::iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			delete (*it);
+		}
+		m_scalers.clear();
+		m_stages.clear();
+	}
+	
+	void ScalerChain::addScaler(const Scaler& scaler) {
+		m_scalers.push_back(scaler.clone());
+		updateStages();
+	}
+	size_t ScalerChain::numScalers() const {
+		return m_scalers.size();
+	}
+	const Scaler& ScalerChain::getScaler(size_t i) const {
+		assert(i < m_scalers.size());
+		return *m_scalers[i];
+	}
+	size_t ScalerChain::numStages() const {
+		return m_stages.size();
+	}
+	void ScalerChain::updateStages() {
+		m_stages.clear();
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			Stage stage;
+			stage.scaler = 0;
+			stage.impute = false;
+			stage.imputedValue = 0.0;
+			if ((*it)->getPiecewiseLinear(stage.function)) {
+				stage.impute = ((*it)->getMissingValuePolicy(stage.imputedValue) == ImputeMissing);
+				PiecewiseLinear composed;
+				if (!m_stages.empty() && m_stages.back().scaler == 0 && PiecewiseLinear::compose(stage.function, m_stages.back().function, composed)) {
+					Stage& previous = m_stages.back();
+					//missing values stay missing in the functions, so the first imputing scaler imputes and the functions after it scale its imputed value
+					if (previous.impute) {
+						previous.imputedValue = stage.function(previous.imputedValue);
+					} else {
+						previous.impute = stage.impute;
+						previous.imputedValue = stage.imputedValue;
+					}
+					previous.function = composed;
+					previous.inverse = composed.inverse();
+					continue;
+				}
+				stage.inverse = stage.function.inverse();
+			} else {
+				stage.scaler = *it;
+			}
+			m_stages.push_back(stage);
+		}
+	}
+	
+	void ScalerChain::fit(std::vector<double>& values, bool reset) {
+		const size_t num = values.size();
+		for (size_t i = 0; i < m_scalers.size(); i++) {
+			if (reset) {
+				m_scalers[i]->resetScalingFactors(&values[0], 1, num);
+			} else {
+				m_scalers[i]->updateScalingFactors(&values[0], 1, num);
+			}
+			if (i+1 < m_scalers.size()) {
+				m_scalers[i]->scale(&values[0], 1, &values[0], 1, num);
+			}
+		}
+		updateStages();
+	}
+	void ScalerChain::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		std::vector<double> values(num);
+		for (size_t i = 0; i < num; i++) {
+			values[i] = data[i*offset];
+		}
+		fit(values, false);
+	}
+	void ScalerChain::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		std::vector<double> values(num);
+		for (size_t i = 0; i < num; i++) {
+			values[i] = data[i][offset];
+		}
+		fit(values, false);
+	}
+	void ScalerChain::updateScalingFactors(double value) {
+		std::vector<Scaler*>::iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			(*it)->updateScalingFactors(value);
+			value = (*it)->scale(value);
+		}
+		updateStages();
+	}
+	void ScalerChain::updateScalingFactorsRepeated(double value, size_t num) {
+		std::vector<Scaler*>::iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			(*it)->updateScalingFactorsRepeated(value, num);
+			value = (*it)->scale(value);
+		}
+		updateStages();
+	}
+	void ScalerChain::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		std::vector<double> values(num);
+		for (size_t i = 0; i < num; i++) {
+			values[i] = data[i*offset];
+		}
+		fit(values, true);
+	}
+	void ScalerChain::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		std::vector<double> values(num);
+		for (size_t i = 0; i < num; i++) {
+			values[i] = data[i][offset];
+		}
+		fit(values, true);
+	}
+	
+	void ScalerChain::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		if (m_stages.empty()) {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = in[i*inOffset];
+			}
+			return;
+		}
+		//the first stage reads in, the others work on out
+		double const* source = in;
+		int sourceOffset = inOffset;
+		std::vector<Stage>::const_iterator it;
+		for (it = m_stages.begin(); it != m_stages.end(); it++) {
+			if (it->scaler == 0 && it->impute) {
+				const PiecewiseLinear& function = it->function;
+				const double imputed = it->imputedValue;
+				for (size_t i = 0; i < num; i++) {
+					const double value = source[i*sourceOffset];
+					out[i*outOffset] = imputeMissing(value, function(value), imputed);
+				}
+			} else if (it->scaler == 0 && it->function.isAffine()) {
+				const double slope = it->function.slope();
+				const double intercept = it->function.intercept();
+				for (size_t i = 0; i < num; i++) {
+					out[i*outOffset] = source[i*sourceOffset]*slope + intercept;
+				}
+			} else if (it->scaler == 0) {
+				const PiecewiseLinear& function = it->function;
+				for (size_t i = 0; i < num; i++) {
+					out[i*outOffset] = function(source[i*sourceOffset]);
+				}
+			} else {
+				it->scaler->scale(source, sourceOffset, out, outOffset, num);
+			}
+			source = out;
+			sourceOffset = static_cast<int>(outOffset);
+		}
+	}
+	void ScalerChain::scale(double** data, size_t offset, size_t num) const {
+		std::vector<Stage>::const_iterator it;
+		for (it = m_stages.begin(); it != m_stages.end(); it++) {
+			if (it->scaler == 0 && it->impute) {
+				const PiecewiseLinear& function = it->function;
+				const double imputed = it->imputedValue;
+				for (size_t i = 0; i < num; i++) {
+					const double value = data[i][offset];
+					data[i][offset] = imputeMissing(value, function(value), imputed);
+				}
+			} else if (it->scaler == 0) {
+				const PiecewiseLinear& function = it->function;
+				for (size_t i = 0; i < num; i++) {
+					data[i][offset] = function(data[i][offset]);
+				}
+			} else {
+				it->scaler->scale(data, offset, num);
+			}
+		}
+	}
+	double ScalerChain::scale(double value) const {
+		std::vector<Stage>::const_iterator it;
+		for (it = m_stages.begin(); it != m_stages.end(); it++) {
+			if (it->scaler != 0) {
+				value = it->scaler->scale(value);
+			} else if (it->impute) {
+				value = imputeMissing(value, it->function(value), it->imputedValue);
+			} else {
+				value = it->function(value);
+			}
+		}
+		return value;
+	}
+	double ScalerChain::originalValue(double value) const {
+		std::vector<Stage>::const_reverse_iterator it;
+		for (it = m_stages.rbegin(); it != m_stages.rend(); it++) {
+			value = (it->scaler == 0) ? it->inverse(value) : it->scaler->originalValue(value);
+		}
+		return value;
+	}
+	
+	bool ScalerChain::getPiecewiseLinear(PiecewiseLinear& function) const {
+		if (m_stages.empty()) {
+			function = PiecewiseLinear();
+			return true;
+		}
+		if (m_stages.size() == 1 && m_stages[0].scaler == 0) {
+			function = m_stages[0].function;
+			return true;
+		}
+		return false;
+	}
+	MissingValuePolicy ScalerChain::getMissingValuePolicy(double& imputedValue) const {
+		if (m_stages.size() == 1 && m_stages[0].scaler == 0 && m_stages[0].impute) {
+			imputedValue = m_stages[0].imputedValue;
+			return ImputeMissing;
+		}
+		return PropagateMissing;
+	}
+	bool ScalerChain::isExtremaSufficient() const {
+		if (m_scalers.empty()) {
+			return false;
+		}
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			if (!(*it)->isExtremaSufficient()) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool ScalerChain::getNormRange(double& minNorm, double& maxNorm) const {
+		if (m_scalers.empty()) {
+			return false;
+		}
+		return m_scalers.back()->getNormRange(minNorm, maxNorm);
+	}
+	
+	void ScalerChain::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(static_cast<double>(m_scalers.size()));
+		std::vector<Scaler*>::const_iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			std::vector<double> scalerParams;
+			(*it)->getParameters(scalerParams);
+			params.push_back(static_cast<double>(scalerParams.size()));
+			params.insert(params.end(), scalerParams.begin(), scalerParams.end());
+		}
+	}
+	void ScalerChain::setParameters(const std::vector<double>& params) {
+		assert(!params.empty());
+		assert(static_cast<size_t>(params[0]) == m_scalers.size());
+		size_t position = 1;
+		std::vector<Scaler*>::iterator it;
+		for (it = m_scalers.begin(); it != m_scalers.end(); it++) {
+			assert(position < params.size());
+			const size_t numParams = static_cast<size_t>(params[position]);
+			assert(position + 1 + numParams <= params.size());
+			std::vector<double> scalerParams(params.begin() + position + 1, params.begin() + position + 1 + numParams);
+			(*it)->setParameters(scalerParams);
+			position += 1 + numParams;
+		}
+		updateStages();
+	}
+	const std::string& ScalerChain::getTypeName() const {
+		return m_name;
+	}
+	Scaler* ScalerChain::clone() const {
+		return new ScalerChain(*this);
+	}
+	void ScalerChain::merge(const Scaler& other) {
+		checkMergeable(other);
+		const ScalerChain& o = static_cast<const ScalerChain&>(other);
+		if (o.m_scalers.size() != m_scalers.size()) {
+			throw MergeException("the ScalerChains have different lengths");
+		}
+		if (m_scalers.empty()) {
+			return;
+		}
+		//the scalers after the first one were fitted on values in the units of the scalers in front of them, which differ between the chains
+		if (!isExtremaSufficient() || !o.isExtremaSufficient()) {
+			throw MergeException("only ScalerChains of scalers that can be fitted from extrema can be merged");
+		}
+		double extrema[2];
+		if (!m_scalers[0]->getNormRange(extrema[0], extrema[1])) {
+			throw MergeException("the first scaler of the ScalerChain has no norm range");
+		}
+		//the scalers are merged into copies, so the chain is not changed if one of them throws (the merges of the later scalers only check their configuration)
+		std::vector<Scaler*> merged;
+		try {
+			for (size_t i = 0; i < m_scalers.size(); i++) {
+				merged.push_back(m_scalers[i]->clone());
+				merged.back()->merge(*o.m_scalers[i]);
+			}
+		} catch (MergeException&) {
+			std::vector<Scaler*>::iterator it;
+			for (it = merged.begin(); it != merged.end(); it++) {
+				delete (*it);
+			}
+			throw;
+		}
+		m_scalers.swap(merged);
+		std::vector<Scaler*>::iterator it;
+		for (it = merged.begin(); it != merged.end(); it++) {
+			delete (*it);
+		}
+		//the first scaler scales the extrema of the merged values to its norm range, the later scalers are refitted with the scaled extrema like by a reset with all values
+		for (size_t i = 1; i < m_scalers.size(); i++) {
+			m_scalers[i]->resetScalingFactors(extrema, 1, 2);
+			extrema[0] = m_scalers[i]->scale(extrema[0]);
+			extrema[1] = m_scalers[i]->scale(extrema[1]);
+		}
+		updateStages();
+	}
+}
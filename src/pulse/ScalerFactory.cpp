@@ -39,15 +39,97 @@
 
 #include <pulse/Normalize.h>
 #include <pulse/NormalizeWithFixpoint.h>
+#include <pulse/SlidingWindowNormalize.h>
+#include <pulse/ExponentialDecayNormalize.h>
+#include <pulse/Standardize.h>
+#include <pulse/RobustNormalize.h>
+#include <pulse/QuantileTransform.h>
+#include <pulse/TransformedNormalize.h>
+#include <pulse/ScalerChain.h>
 
 #include <pulse/CSVReader.h>
+#include <pulse/Instrumentation.h>
 
 #include <cassert>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <sstream>
 
 namespace pulse {
+	namespace {
+		/** Reads numParameters parameters from the current line into scaler.
+		 *  The factory owns scaler, it is deleted if the parameters can not be read.
+		 */
+		Scaler* readParameters(Scaler* scaler, size_t numParameters, CSVReader& reader) {
+			std::vector<double> tmp;
+			try {
+				reader.readEntries(numParameters, tmp);
+			} catch (ParseException&) {
+				delete scaler;
+				throw;
+			}
+			if (!reader.isAtLineStart()) {
+				std::string type = scaler->getTypeName();
+				delete scaler;
+				throw ParseException("too many parameters for " + type);
+			}
+			scaler->setParameters(tmp);
+			return scaler;
+		}
+		/** Reads all remaining parameters of the current line into scaler, for scalers with a variable number of parameters.
+		 *  The factory owns scaler, it is deleted if the parameters can not be read or if isValid rejects them.
+		 */
+		Scaler* readAllParameters(Scaler* scaler, size_t minParameters, bool (*isValid)(const std::vector<double>&), CSVReader& reader) {
+			std::vector<double> tmp;
+			try {
+				while (reader.good() && !reader.isAtLineStart()) {
+					reader.readEntries(1, tmp);
+				}
+			} catch (ParseException&) {
+				delete scaler;
+				throw;
+			}
+			if (tmp.size() < minParameters) {
+				std::string type = scaler->getTypeName();
+				delete scaler;
+				throw ParseException("too few parameters for " + type);
+			}
+			if (!isValid(tmp)) {
+				std::string type = scaler->getTypeName();
+				delete scaler;
+				throw ParseException("invalid parameters for " + type);
+			}
+			scaler->setParameters(tmp);
+			return scaler;
+		}
+		/** Creates a scaler of the given type with the parameters of the current line, returns 0 if the type is unknown */
+		Scaler* readScaler(const std::string& t, CSVReader& reader) {
+			if (t.compare(std::string("Normalize")) == 0) {
+				return readParameters(new Normalize(0.0, 1.0), 4, reader);
+			} else if (t.compare(std::string("NormalizeWithFixpoint")) == 0) {
+				return readParameters(new NormalizeWithFixpoint(0.0, 0.0, -1.0, 1.0), 6, reader);
+			} else if (t.compare(std::string("SlidingWindowNormalize")) == 0) {
+				return readParameters(new SlidingWindowNormalize(0.0, 1.0, 1), 5, reader);
+			} else if (t.compare(std::string("ExponentialDecayNormalize")) == 0) {
+				return readParameters(new ExponentialDecayNormalize(0.0, 1.0, 1.0, 1.0), 7, reader);
+			} else if (t.compare(std::string("Standardize")) == 0) {
+				return readParameters(new Standardize(), 3, reader);
+			} else if (t.compare(std::string("RobustNormalize")) == 0) {
+				return readAllParameters(new RobustNormalize(0.0, 1.0), 5 + QuantileSketch::numHeaderParameters, &RobustNormalize::checkParameters, reader);
+			} else if (t.compare(std::string("QuantileTransform")) == 0) {
+				return readAllParameters(new QuantileTransform(0.0, 1.0, 2), 5 + QuantileSketch::numHeaderParameters, &QuantileTransform::checkParameters, reader);
+			} else if (t.compare(std::string("Log1pNormalize")) == 0) {
+				return readParameters(new Log1pNormalize(0.0, 1.0), 5, reader);
+			} else if (t.compare(std::string("SignedLogNormalize")) == 0) {
+				return readParameters(new SignedLogNormalize(0.0, 1.0), 5, reader);
+			} else if (t.compare(std::string("TanhNormalize")) == 0) {
+				return readParameters(new TanhNormalize(0.0, 1.0), 5, reader);
+			}
+			return 0;
+		}
+	}
+	
 	ScalerFactory::ScalerFactory(const std::string& file) : m_filePath(file) {
 		
 	}
@@ -55,6 +137,7 @@ namespace pulse {
 		
 	}
 	size_t ScalerFactory::getMaxId(const std::string& prefix) throw (FileOpenException, ParseException) {
+		PULSE_TIME(ParseTime);
 		size_t result = 0;
 		CSVReader reader(m_filePath);
 		//search id
@@ -70,51 +153,58 @@ namespace pulse {
 					}
 				}
 			}
-			if (reader.good()) {
-				//jump over the other fields
-				std::string t = reader.readEntry();
-				if (t.compare(std::string("Normalize")) == 0) {
-					std::vector<double> tmp;
-					reader.readEntries(4, tmp);
-				} else if (t.compare(std::string("NormalizeWithFixpoint")) == 0) {
-					std::vector<double> tmp;
-					reader.readEntries(6, tmp);
-				}
+			if (reader.good() && !reader.isAtLineStart()) {
+				//jump over the type and the parameters, this works for every scaler type
+				reader.goToNextLine();
 			}
 		}
 		return result;
 	}
 	Scaler* ScalerFactory::getScaler(const std::string& id) throw (FileOpenException, ParseException) {
+		PULSE_TIME(ParseTime);
+		return loadScaler(id);
+	}
+	Scaler* ScalerFactory::loadScaler(const std::string& id) throw (FileOpenException, ParseException) {
 		CSVReader reader(m_filePath);
 		//search id
 		while (reader.good() && !false) {
 			std::string currentId = reader.readEntry();
 			if (currentId.compare(id) == 0) {
-				Scaler* re = 0;
 				//parse type
 				std::string t = reader.readEntry();
-				if (t.compare(std::string("Normalize")) == 0) {
-					re = new Normalize(0.0,1.0);
-					std::vector<double> tmp;
-					reader.readEntries(4, tmp);
-					re->setParameters(tmp);
-					if (!reader.isAtLineStart()) {
-						throw ParseException("too many parameters for Normalize");
-					}
-					return re;
-				} else if (t.compare(std::string("NormalizeWithFixpoint")) == 0) {
-					re = new NormalizeWithFixpoint(0.0, 0.0, -1.0, 1.0);
-					std::vector<double> tmp;
-					reader.readEntries(6, tmp);
-					re->setParameters(tmp);
-					if (!reader.isAtLineStart()) {
-						throw ParseException("too many parameters for NormalizeWithFixpoint");
-					}
-					return re;
+				if (t.compare(std::string("ScalerChain")) == 0) {
+					return loadChain(id, reader);
 				}
-				throw ParseException("Unknown scaler type");
+				Scaler* re = readScaler(t, reader);
+				if (re == 0) {
+					throw ParseException("Unknown scaler type");
+				}
+				return re;
+			} else if (reader.good() && !reader.isAtLineStart()) {
+				//the parameters of other scalers are no ids
+				reader.goToNextLine();
 			}
 		}
 		throw ParseException("Scaler not found");
 	}
+	Scaler* ScalerFactory::loadChain(const std::string& id, CSVReader& reader) throw (FileOpenException, ParseException) {
+		std::vector<double> tmp;
+		reader.readEntries(1, tmp);
+		if (!reader.isAtLineStart()) {
+			throw ParseException("too many parameters for ScalerChain");
+		}
+		if (tmp[0] < 1.0) {
+			throw ParseException("ScalerChain without scalers");
+		}
+		const size_t numScalers = static_cast<size_t>(tmp[0]);
+		ScalerChain chain;
+		for (size_t i = 1; i <= numScalers; i++) {
+			std::stringstream sstr;
+			sstr<<id<<"."<<i;
+			Scaler* s = loadScaler(sstr.str());
+			chain.addScaler(*s);
+			delete s;
+		}
+		return chain.clone();
+	}
 }
\ No newline at end of file
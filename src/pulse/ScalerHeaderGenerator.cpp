@@ -0,0 +1,162 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/ScalerHeaderGenerator.h>
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <pulse/Scaler.h>
+#include <pulse/ScalerFactory.h>
+
+namespace pulse {
+	namespace {
+		void loadFunctions(ScalerFactory& factory, const std::string& prefix, std::vector<PiecewiseLinear>& functions) {
+			size_t num = factory.getMaxId(prefix);
+			if (num == 0) {
+				throw ParseException("no " + prefix + " scalers found");
+			}
+			for (size_t i = 1; i <= num; i++) {
+				std::stringstream sstr;
+				sstr<<prefix<<i;
+				Scaler* s = factory.getScaler(sstr.str());
+				PiecewiseLinear f;
+				bool supported = s->getPiecewiseLinear(f);
+				std::string type = s->getTypeName();
+				delete s;
+				if (!supported) {
+					throw ParseException("code generation is not supported for the scaler type " + type + " of " + sstr.str());
+				}
+				functions.push_back(f);
+			}
+		}
+		std::string literal(double value) {
+			if (value != value) {
+				return "std::numeric_limits<double>::quiet_NaN()";
+			} else if (value == std::numeric_limits<double>::infinity()) {
+				return "std::numeric_limits<double>::infinity()";
+			} else if (value == -std::numeric_limits<double>::infinity()) {
+				return "-std::numeric_limits<double>::infinity()";
+			}
+			std::stringstream sstr;
+			sstr.precision(std::numeric_limits<double>::digits10 + 2);
+			sstr<<value;
+			return sstr.str();
+		}
+		void writeArray(std::ostream& out, const std::string& name, const std::vector<double>& values) {
+			out<<"\tconstexpr double "<<name<<"["<<values.size()<<"] = {";
+			std::vector<double>::const_iterator it;
+			for (it = values.begin(); it != values.end(); it++) {
+				if (it != values.begin()) {
+					out<<", ";
+				}
+				out<<literal(*it);
+			}
+			out<<"};\n";
+		}
+		void writeFunctions(std::ostream& out, const std::string& prefix, const std::vector<PiecewiseLinear>& functions) {
+			std::vector<double> pivot, pivotValue, slopeBelow, slopeAbove;
+			std::vector<PiecewiseLinear>::const_iterator it;
+			for (it = functions.begin(); it != functions.end(); it++) {
+				pivot.push_back(it->pivot);
+				pivotValue.push_back(it->pivotValue);
+				slopeBelow.push_back(it->slopeBelow);
+				slopeAbove.push_back(it->slopeAbove);
+			}
+			writeArray(out, prefix + "Pivot", pivot);
+			writeArray(out, prefix + "PivotValue", pivotValue);
+			writeArray(out, prefix + "SlopeBelow", slopeBelow);
+			writeArray(out, prefix + "SlopeAbove", slopeAbove);
+		}
+	}
+	
+	ScalerHeaderGenerator::ScalerHeaderGenerator(const std::string& scalerFile) throw (FileOpenException, ParseException) : m_scalerFile(scalerFile) {
+		ScalerFactory factory(scalerFile);
+		loadFunctions(factory, "input", m_inputFunctions);
+		std::vector<PiecewiseLinear> targetScaling;
+		loadFunctions(factory, "target", targetScaling);
+		//the header only needs to restore the original target values
+		std::vector<PiecewiseLinear>::const_iterator it;
+		for (it = targetScaling.begin(); it != targetScaling.end(); it++) {
+			m_targetFunctions.push_back(it->inverse());
+		}
+	}
+	ScalerHeaderGenerator::~ScalerHeaderGenerator() {
+		
+	}
+	void ScalerHeaderGenerator::write(std::ostream& out, const std::string& ns) const {
+		out<<"#pragma once\n\n";
+		out<<"/* Generated from "<<m_scalerFile<<", do not edit. */\n\n";
+		out<<"#include <cstddef>\n";
+		out<<"#include <limits>\n\n";
+		out<<"namespace "<<ns<<" {\n";
+		out<<"\tconstexpr std::size_t numInputDimensions = "<<m_inputFunctions.size()<<";\n";
+		out<<"\tconstexpr std::size_t numTargetDimensions = "<<m_targetFunctions.size()<<";\n\n";
+		out<<"\t// x -> pivotValue + (x-pivot)*(x < pivot ? slopeBelow : slopeAbove)\n";
+		writeFunctions(out, "input", m_inputFunctions);
+		out<<"\n\t// scaled target -> original target value, same form as the input scaling\n";
+		writeFunctions(out, "target", m_targetFunctions);
+		out<<"\n";
+		out<<"\t/** Scales a single input value of the dimension i */\n";
+		out<<"\tconstexpr double scaleInput(std::size_t i, double value) {\n";
+		out<<"\t\treturn inputPivotValue[i] + (value-inputPivot[i])*(value < inputPivot[i] ? inputSlopeBelow[i] : inputSlopeAbove[i]);\n";
+		out<<"\t}\n";
+		out<<"\t/** Returns the original value of the scaled target value of the dimension i */\n";
+		out<<"\tconstexpr double originalTargetValue(std::size_t i, double value) {\n";
+		out<<"\t\treturn targetPivotValue[i] + (value-targetPivot[i])*(value < targetPivot[i] ? targetSlopeBelow[i] : targetSlopeAbove[i]);\n";
+		out<<"\t}\n";
+		out<<"\t/** Scales the values (numInputDimensions entries) in place */\n";
+		out<<"\tinline void scaleInput(double* values) {\n";
+		out<<"\t\tfor (std::size_t i = 0; i < numInputDimensions; i++) {\n";
+		out<<"\t\t\tconst double d = values[i]-inputPivot[i];\n";
+		out<<"\t\t\tvalues[i] = inputPivotValue[i] + d*(d < 0.0 ? inputSlopeBelow[i] : inputSlopeAbove[i]);\n";
+		out<<"\t\t}\n";
+		out<<"\t}\n";
+		out<<"\t/** Takes scaled values (numTargetDimensions entries) and returns them to their original not scaled values */\n";
+		out<<"\tinline void originalTargetValues(double* values) {\n";
+		out<<"\t\tfor (std::size_t i = 0; i < numTargetDimensions; i++) {\n";
+		out<<"\t\t\tconst double d = values[i]-targetPivot[i];\n";
+		out<<"\t\t\tvalues[i] = targetPivotValue[i] + d*(d < 0.0 ? targetSlopeBelow[i] : targetSlopeAbove[i]);\n";
+		out<<"\t\t}\n";
+		out<<"\t}\n";
+		out<<"}\n";
+	}
+	void ScalerHeaderGenerator::writeToFile(const std::string& filename, const std::string& ns) const throw (FileOpenException) {
+		std::ofstream out(filename.c_str(), std::ios_base::out | std::fstream::trunc);
+		if (!out.good()) {
+			throw FileOpenException(filename);
+		}
+		write(out, ns);
+	}
+}
@@ -36,6 +36,10 @@
  */
 
 #include <pulse/ScalerSaver.h>
+#include <pulse/ScalerChain.h>
+
+#include <limits>
+#include <sstream>
 
 namespace pulse {
 	ScalerSaver::ScalerSaver(const std::string& filename) throw(FileOpenException) : m_seperator("\t") {
@@ -43,11 +47,13 @@ namespace pulse {
 		if (!m_ofstream.good()) {
 			throw FileOpenException(filename);
 		}
+		//write out enough digits to restore the exact parameters
+		m_ofstream.precision(std::numeric_limits<double>::digits10 + 2);
 	}
 	ScalerSaver::~ScalerSaver() {
 		m_ofstream.close();
 	}
-	void ScalerSaver::saveScaler(const std::string& id, Scaler* scaler) {
+	void ScalerSaver::saveScaler(const std::string& id, const Scaler* scaler) {
 		//write out id
 		m_ofstream<<id;
 		
@@ -55,6 +61,20 @@ namespace pulse {
 		m_ofstream<<m_seperator;
 		m_ofstream<<scaler->getTypeName();
 		
+		//a chain is written as the number of its scalers followed by a line for every scaler
+		if (scaler->getTypeName() == "ScalerChain") {
+			const ScalerChain* chain = static_cast<const ScalerChain*>(scaler);
+			m_ofstream<<m_seperator;
+			m_ofstream<<chain->numScalers();
+			m_ofstream<<'\n';
+			for (size_t i = 0; i < chain->numScalers(); i++) {
+				std::stringstream sstr;
+				sstr<<id<<"."<<(i+1);
+				saveScaler(sstr.str(), &chain->getScaler(i));
+			}
+			return;
+		}
+		
 		//write out parameters
 		std::vector<double> params;
 		scaler->getParameters(params);
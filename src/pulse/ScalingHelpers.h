@@ -0,0 +1,165 @@
+#pragma once
+
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace pulse {
+	/** Branchless helpers shared by the scaling and fitting loops in src/pulse, not part of the public interface */
+	namespace detail {
+		/** below if the sign bit of d is set and above otherwise. The selection uses the sign bit as mask, a ?: on doubles is not vectorized by gcc with the default -ftrapping-math */
+		inline double selectBySign(double d, double below, double above) {
+			int64_t bitsD;
+			uint64_t bitsBelow;
+			uint64_t bitsAbove;
+			memcpy(&bitsD, &d, sizeof(bitsD));
+			memcpy(&bitsBelow, &below, sizeof(bitsBelow));
+			memcpy(&bitsAbove, &above, sizeof(bitsAbove));
+			const uint64_t mask = static_cast<uint64_t>(bitsD >> 63);
+			const uint64_t bits = (bitsBelow & mask) | (bitsAbove & ~mask);
+			double re;
+			memcpy(&re, &bits, sizeof(re));
+			return re;
+		}
+		/** float version of selectBySign(double, double, double) */
+		inline float selectBySign(float d, float below, float above) {
+			int32_t bitsD;
+			uint32_t bitsBelow;
+			uint32_t bitsAbove;
+			memcpy(&bitsD, &d, sizeof(bitsD));
+			memcpy(&bitsBelow, &below, sizeof(bitsBelow));
+			memcpy(&bitsAbove, &above, sizeof(bitsAbove));
+			const uint32_t mask = static_cast<uint32_t>(bitsD >> 31);
+			const uint32_t bits = (bitsBelow & mask) | (bitsAbove & ~mask);
+			float re;
+			memcpy(&re, &bits, sizeof(re));
+			return re;
+		}
+		/** 1 for NaN and infinite values, 0 otherwise. value-value is +0 for finite values and NaN otherwise, so the highest exponent bit of the difference is the mask and no branch is needed */
+		inline uint64_t isMissing(double value) {
+			const double difference = value - value;
+			uint64_t bits;
+			memcpy(&bits, &difference, sizeof(bits));
+			return (bits >> 62) & 1;
+		}
+		/** float version of isMissing(double) */
+		inline uint32_t isMissing(float value) {
+			const float difference = value - value;
+			uint32_t bits;
+			memcpy(&bits, &difference, sizeof(bits));
+			return (bits >> 30) & 1;
+		}
+		/** value for finite values and NaN otherwise, NaN fails every comparison and is skipped by the min max search */
+		inline double maskMissing(double value) {
+			return value + (value - value);
+		}
+		/** imputed if value is missing and enabled is ~0, scaled otherwise. Selected with the mask of isMissing so the loops using it still vectorize like with selectBySign(), enabled lets dimensions with different policies share one loop */
+		inline double imputeMissing(double value, double scaled, double imputed, uint64_t enabled) {
+			const uint64_t mask = (0 - isMissing(value)) & enabled;
+			uint64_t bitsScaled;
+			uint64_t bitsImputed;
+			memcpy(&bitsScaled, &scaled, sizeof(bitsScaled));
+			memcpy(&bitsImputed, &imputed, sizeof(bitsImputed));
+			const uint64_t bits = (bitsScaled & ~mask) | (bitsImputed & mask);
+			double re;
+			memcpy(&re, &bits, sizeof(re));
+			return re;
+		}
+		/** float version of imputeMissing(double, double, double, uint64_t) */
+		inline float imputeMissing(float value, float scaled, float imputed, uint32_t enabled) {
+			const uint32_t mask = (0 - isMissing(value)) & enabled;
+			uint32_t bitsScaled;
+			uint32_t bitsImputed;
+			memcpy(&bitsScaled, &scaled, sizeof(bitsScaled));
+			memcpy(&bitsImputed, &imputed, sizeof(bitsImputed));
+			const uint32_t bits = (bitsScaled & ~mask) | (bitsImputed & mask);
+			float re;
+			memcpy(&re, &bits, sizeof(re));
+			return re;
+		}
+		/** imputed if value is missing and scaled otherwise */
+		inline double imputeMissing(double value, double scaled, double imputed) {
+			return imputeMissing(value, scaled, imputed, ~static_cast<uint64_t>(0));
+		}
+		/** float version of imputeMissing(double, double, double) */
+		inline float imputeMissing(float value, float scaled, float imputed) {
+			return imputeMissing(value, scaled, imputed, ~static_cast<uint32_t>(0));
+		}
+		
+		/** The unsigned integer type with the bits of T */
+		template<class T>
+		struct BitsOf;
+		template<>
+		struct BitsOf<double> {
+			typedef uint64_t type;
+		};
+		template<>
+		struct BitsOf<float> {
+			typedef uint32_t type;
+		};
+		
+		/** data[i*offset], lets the fitting and scaling loops be written once for strided data and for PatternSets */
+		struct StridedAccessor {
+			StridedAccessor(double const* data, size_t offset) : data(data), offset(offset) {}
+			inline double operator()(size_t i) const {
+				return data[i*offset];
+			}
+			double const* data;
+			size_t offset;
+		};
+		/** data[i*offset] */
+		struct StridedOutput {
+			StridedOutput(double* data, size_t offset) : data(data), offset(offset) {}
+			inline double& operator()(size_t i) const {
+				return data[i*offset];
+			}
+			double* data;
+			size_t offset;
+		};
+		/** data[i][offset], for reading and writing */
+		struct RowAccessor {
+			RowAccessor(double** const data, size_t offset) : data(data), offset(offset) {}
+			inline double& operator()(size_t i) const {
+				return data[i][offset];
+			}
+			double** const data;
+			size_t offset;
+		};
+	}
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+
+#include <pulse/ScalingTable.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace pulse {
+	ScalingTable::ScalingTable() {
+		
+	}
+	bool ScalingTable::Key::operator<(const Key& other) const {
+		for (size_t i = 0; i < 4; i++) {
+			if (bits[i] != other.bits[i]) {
+				return bits[i] < other.bits[i];
+			}
+		}
+		return false;
+	}
+	uint32_t ScalingTable::intern(const PiecewiseLinear& function) {
+		Key key;
+		memcpy(&key.bits[0], &function.pivot, sizeof(uint64_t));
+		memcpy(&key.bits[1], &function.pivotValue, sizeof(uint64_t));
+		memcpy(&key.bits[2], &function.slopeBelow, sizeof(uint64_t));
+		memcpy(&key.bits[3], &function.slopeAbove, sizeof(uint64_t));
+		std::map<Key, uint32_t>::const_iterator it = m_indices.find(key);
+		if (it != m_indices.end()) {
+			return it->second;
+		}
+		const uint32_t index = static_cast<uint32_t>(m_functions.size());
+		m_functions.push_back(function);
+		m_indices.insert(std::make_pair(key, index));
+		return index;
+	}
+	const PiecewiseLinear& ScalingTable::get(uint32_t index) const {
+		assert(index < m_functions.size());
+		return m_functions[index];
+	}
+	size_t ScalingTable::size() const {
+		return m_functions.size();
+	}
+}
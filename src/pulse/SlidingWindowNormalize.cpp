@@ -0,0 +1,240 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/SlidingWindowNormalize.h>
+
+#include <cassert>
+
+namespace pulse {
+	std::string SlidingWindowNormalize::m_name = std::string("SlidingWindowNormalize");
+	
+	SlidingWindowNormalize::SlidingWindowNormalize(double minNorm, double maxNorm, size_t windowSize) :
+		m_numSeen(0),
+		m_windowSize(windowSize),
+		m_min(0.0),
+		m_max(1.0),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm)
+	{
+		assert(minNorm < maxNorm);
+		assert(windowSize > 0);
+	}
+	SlidingWindowNormalize::SlidingWindowNormalize(double minNorm, double maxNorm, size_t windowSize, double seenMin, double seenMax) :
+		m_numSeen(0),
+		m_windowSize(windowSize),
+		m_min(seenMin),
+		m_max(seenMax),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm)
+	{
+		assert(minNorm < maxNorm);
+		assert(seenMin < seenMax);
+		assert(windowSize > 0);
+		pushRange(seenMin, seenMax);
+		updateRange();
+	}
+	inline void SlidingWindowNormalize::push(double value) {
+		const unsigned long index = m_numSeen++;
+		//NaN would break the ordering of the deques
+		if (value == value) {
+			//values that are not smaller/bigger than the new one can never become the minimum/maximum again
+			while (!m_minCandidates.empty() && m_minCandidates.back().value >= value) {
+				m_minCandidates.pop_back();
+			}
+			while (!m_maxCandidates.empty() && m_maxCandidates.back().value <= value) {
+				m_maxCandidates.pop_back();
+			}
+			Entry e;
+			e.index = index;
+			e.value = value;
+			m_minCandidates.push_back(e);
+			m_maxCandidates.push_back(e);
+		}
+		expire(index);
+	}
+	void SlidingWindowNormalize::pushRange(double min, double max) {
+		const unsigned long index = m_numSeen++;
+		while (!m_minCandidates.empty() && m_minCandidates.back().value >= min) {
+			m_minCandidates.pop_back();
+		}
+		while (!m_maxCandidates.empty() && m_maxCandidates.back().value <= max) {
+			m_maxCandidates.pop_back();
+		}
+		Entry e;
+		e.index = index;
+		e.value = min;
+		m_minCandidates.push_back(e);
+		e.value = max;
+		m_maxCandidates.push_back(e);
+		expire(index);
+	}
+	inline void SlidingWindowNormalize::expire(unsigned long index) {
+		while (!m_minCandidates.empty() && m_minCandidates.front().index + m_windowSize <= index) {
+			m_minCandidates.pop_front();
+		}
+		while (!m_maxCandidates.empty() && m_maxCandidates.front().index + m_windowSize <= index) {
+			m_maxCandidates.pop_front();
+		}
+	}
+	void SlidingWindowNormalize::skip(unsigned long num) {
+		clear();
+		m_numSeen += num;
+	}
+	void SlidingWindowNormalize::clear() {
+		m_minCandidates.clear();
+		m_maxCandidates.clear();
+	}
+	void SlidingWindowNormalize::updateRange() {
+		if (m_minCandidates.empty()) {
+			//only NaNs in the window, keep the old range
+			return;
+		}
+		m_min = m_minCandidates.front().value;
+		m_max = m_maxCandidates.front().value;
+		//make sure that m_min < m_max (same as Normalize, but without logging as constant windows are common in streams)
+		if (m_max - m_min == 0.0) {
+			m_max = m_max + m_max*m_max + 1.0;
+		}
+	}
+	void SlidingWindowNormalize::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		size_t first = 0;
+		if (num > m_windowSize) {
+			first = num - m_windowSize;
+			skip(first);
+		}
+		for (size_t i = first; i < num; i++) {
+			push(data[i*offset]);
+		}
+		updateRange();
+	}
+	void SlidingWindowNormalize::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		size_t first = 0;
+		if (num > m_windowSize) {
+			first = num - m_windowSize;
+			skip(first);
+		}
+		for (size_t i = first; i < num; i++) {
+			push(data[i][offset]);
+		}
+		updateRange();
+	}
+	void SlidingWindowNormalize::updateScalingFactors(double value) {
+		push(value);
+		updateRange();
+	}
+	void SlidingWindowNormalize::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		m_numSeen += num - 1;
+		push(value);
+		updateRange();
+	}
+	void SlidingWindowNormalize::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		clear();
+		m_numSeen = 0;
+		updateScalingFactors(data, offset, num);
+	}
+	void SlidingWindowNormalize::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		clear();
+		m_numSeen = 0;
+		updateScalingFactors(data, offset, num);
+	}
+	void SlidingWindowNormalize::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		const double factor = (m_maxNorm-m_minNorm)/(m_max-m_min);
+		for (size_t i = 0; i < num; i++) {
+			out[i*outOffset] = (in[i*inOffset]-m_min)*factor + m_minNorm;
+		}
+	}
+	void SlidingWindowNormalize::scale(double** data, size_t offset, size_t num) const {
+		const double factor = (m_maxNorm-m_minNorm)/(m_max-m_min);
+		for (size_t i = 0; i < num; i++) {
+			data[i][offset] = (data[i][offset]-m_min)*factor + m_minNorm;
+		}
+	}
+	double SlidingWindowNormalize::scale(double value) const {
+		return ((value-m_min)/(m_max-m_min))*(m_maxNorm-m_minNorm)+m_minNorm;
+	}
+	double SlidingWindowNormalize::originalValue(double value) const {
+		return ((value - m_minNorm)/(m_maxNorm-m_minNorm))*(m_max-m_min) + m_min;
+	}
+	bool SlidingWindowNormalize::getPiecewiseLinear(PiecewiseLinear& function) const {
+		const double slope = (m_maxNorm-m_minNorm)/(m_max-m_min);
+		function = PiecewiseLinear(m_min, m_minNorm, slope, slope);
+		return true;
+	}
+	bool SlidingWindowNormalize::getNormRange(double& minNorm, double& maxNorm) const {
+		minNorm = m_minNorm;
+		maxNorm = m_maxNorm;
+		return true;
+	}
+	void SlidingWindowNormalize::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_min);
+		params.push_back(m_max);
+		params.push_back(m_minNorm);
+		params.push_back(m_maxNorm);
+		params.push_back(static_cast<double>(m_windowSize));
+	}
+	void SlidingWindowNormalize::setParameters(const std::vector<double>& params) {
+		assert(params.size() == 5);
+		assert(params[4] >= 1.0);
+		m_minNorm = params[2];
+		m_maxNorm = params[3];
+		m_windowSize = static_cast<size_t>(params[4]);
+		clear();
+		m_numSeen = 0;
+		pushRange(params[0], params[1]);
+		updateRange();
+	}
+	const std::string& SlidingWindowNormalize::getTypeName() const {
+		return m_name;
+	}
+	Scaler* SlidingWindowNormalize::clone() const {
+		return new SlidingWindowNormalize(*this);
+	}
+	void SlidingWindowNormalize::merge(const Scaler& other) {
+		checkMergeable(other);
+		const SlidingWindowNormalize& o = static_cast<const SlidingWindowNormalize&>(other);
+		if (o.m_windowSize != m_windowSize) {
+			throw MergeException("SlidingWindowNormalize scalers with different window sizes can not be merged");
+		}
+		pushRange(o.m_min, o.m_max);
+		updateRange();
+	}
+	size_t SlidingWindowNormalize::getWindowSize() const {
+		return m_windowSize;
+	}
+}
@@ -0,0 +1,297 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/Standardize.h>
+#include "ScalingHelpers.h"
+
+#include <cassert>
+#include <cmath>
+#include <stdint.h>
+
+namespace pulse {
+	namespace {
+		using detail::StridedAccessor;
+		using detail::RowAccessor;
+		using detail::isMissing;
+		using detail::imputeMissing;
+		
+		const size_t numLanes = 4;
+		
+		/** Sums f(data(i)) for i in [0,num) in independent lanes, so the sum can be vectorized. 
+		 *  With skipMissing missing values are replaced by center, so they add nothing, and are counted in missing. */
+		template<class Accessor>
+		double sumOfDifferences(const Accessor& data, size_t num, double center, bool squared, bool skipMissing, size_t& missing) {
+			double sum[numLanes] = {0.0, 0.0, 0.0, 0.0};
+			uint64_t count[numLanes] = {0, 0, 0, 0};
+			const size_t numGroups = num/numLanes;
+			for (size_t g = 0; g < numGroups; g++) {
+				for (size_t j = 0; j < numLanes; j++) {
+					const double value = data(g*numLanes + j);
+					const double d = (skipMissing ? imputeMissing(value, value, center) : value) - center;
+					sum[j] += squared ? d*d : d;
+					count[j] += skipMissing ? isMissing(value) : 0;
+				}
+			}
+			double re = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+			uint64_t numMissing = (count[0] + count[1]) + (count[2] + count[3]);
+			for (size_t i = numGroups*numLanes; i < num; i++) {
+				const double value = data(i);
+				const double d = (skipMissing ? imputeMissing(value, value, center) : value) - center;
+				re += squared ? d*d : d;
+				numMissing += skipMissing ? isMissing(value) : 0;
+			}
+			missing += numMissing;
+			return re;
+		}
+	}
+	
+	std::string Standardize::m_name = std::string("Standardize");
+	
+	Standardize::Standardize() :
+		m_count(0.0),
+		m_mean(0.0),
+		m_m2(0.0),
+		m_inverseDeviation(1.0),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
+	{
+	
+	}
+	Standardize::Standardize(double count, double mean, double deviation) :
+		m_count(count),
+		m_mean(mean),
+		m_m2(deviation*deviation*count),
+		m_inverseDeviation(1.0),
+		m_missingPolicy(PropagateMissing),
+		m_imputedValue(0.0),
+		m_missingCount(0)
+	{
+		assert(count > 0.0);
+		assert(deviation > 0.0);
+		updateCoefficients();
+	}
+	void Standardize::combine(double count, double mean, double m2) {
+		if (count == 0.0) {
+			return;
+		}
+		const double total = m_count + count;
+		const double delta = mean - m_mean;
+		m_mean += delta*(count/total);
+		m_m2 += m2 + delta*delta*(m_count*count/total);
+		m_count = total;
+	}
+	template<class Accessor>
+	void Standardize::update(const Accessor& data, size_t num) {
+		//two passes over the block: mean of the block, then the squared differences from it
+		const bool skipMissing = (m_missingPolicy != PropagateMissing);
+		size_t first = 0;
+		if (skipMissing) {
+			//the shift has to be finite
+			while (first < num && isMissing(data(first))) {
+				first++;
+			}
+			if (first == num) {
+				m_missingCount += num;
+				return;
+			}
+		}
+		const double shift = data(first);
+		size_t missing = 0;
+		const double sum = sumOfDifferences(data, num, shift, false, skipMissing, missing);
+		const double n = static_cast<double>(num - missing);
+		const double blockMean = shift + sum/n;
+		size_t counted = 0;
+		const double blockM2 = sumOfDifferences(data, num, blockMean, true, skipMissing, counted);
+		m_missingCount += missing;
+		combine(n, blockMean, blockM2);
+		updateCoefficients();
+	}
+	void Standardize::updateCoefficients() {
+		const double deviation = (m_count > 0.0) ? sqrt(m_m2/m_count) : 0.0;
+		m_inverseDeviation = (deviation > 0.0) ? 1.0/deviation : 1.0;
+	}
+	void Standardize::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		update(StridedAccessor(data, offset), num);
+	}
+	void Standardize::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		if (num > 0) {
+			update(RowAccessor(data, offset), num);
+		}
+	}
+	void Standardize::updateScalingFactors(double value) {
+		if (m_missingPolicy != PropagateMissing && isMissing(value)) {
+			m_missingCount++;
+			return;
+		}
+		if (value != value) {
+			return;
+		}
+		//Welford
+		m_count += 1.0;
+		const double delta = value - m_mean;
+		m_mean += delta/m_count;
+		m_m2 += delta*(value - m_mean);
+		updateCoefficients();
+	}
+	void Standardize::updateScalingFactorsRepeated(double value, size_t num) {
+		assert(num > 0);
+		if (m_missingPolicy != PropagateMissing && isMissing(value)) {
+			m_missingCount += num;
+			return;
+		}
+		if (value != value) {
+			return;
+		}
+		//the copies have the mean value and no deviation
+		combine(static_cast<double>(num), value, 0.0);
+		updateCoefficients();
+	}
+	void Standardize::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_count = 0.0;
+		m_mean = 0.0;
+		m_m2 = 0.0;
+		updateScalingFactors(data, offset, num);
+	}
+	void Standardize::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_count = 0.0;
+		m_mean = 0.0;
+		m_m2 = 0.0;
+		updateScalingFactors(data, offset, num);
+	}
+	void Standardize::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		const double mean = m_mean;
+		const double factor = m_inverseDeviation;
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			if (inOffset == 1 && outOffset == 1) {
+				//the mask select keeps the contiguous case vectorizable
+				for (size_t i = 0; i < num; i++) {
+					out[i] = imputeMissing(in[i], (in[i]-mean)*factor, imputed);
+				}
+			} else {
+				for (size_t i = 0; i < num; i++) {
+					const double value = in[i*inOffset];
+					out[i*outOffset] = imputeMissing(value, (value-mean)*factor, imputed);
+				}
+			}
+			return;
+		}
+		if (inOffset == 1 && outOffset == 1) {
+			//contiguous case, can be vectorized
+			for (size_t i = 0; i < num; i++) {
+				out[i] = (in[i]-mean)*factor;
+			}
+		} else {
+			for (size_t i = 0; i < num; i++) {
+				out[i*outOffset] = (in[i*inOffset]-mean)*factor;
+			}
+		}
+	}
+	void Standardize::scale(double** data, size_t offset, size_t num) const {
+		const double mean = m_mean;
+		const double factor = m_inverseDeviation;
+		if (m_missingPolicy == ImputeMissing) {
+			const double imputed = m_imputedValue;
+			for (size_t i = 0; i < num; i++) {
+				const double value = data[i][offset];
+				data[i][offset] = imputeMissing(value, (value-mean)*factor, imputed);
+			}
+			return;
+		}
+		for (size_t i = 0; i < num; i++) {
+			data[i][offset] = (data[i][offset]-mean)*factor;
+		}
+	}
+	double Standardize::scale(double value) const {
+		if (m_missingPolicy == ImputeMissing) {
+			return imputeMissing(value, (value-m_mean)*m_inverseDeviation, m_imputedValue);
+		}
+		return (value-m_mean)*m_inverseDeviation;
+	}
+	double Standardize::originalValue(double value) const {
+		return value/m_inverseDeviation + m_mean;
+	}
+	bool Standardize::getPiecewiseLinear(PiecewiseLinear& function) const {
+		function = PiecewiseLinear(m_mean, 0.0, m_inverseDeviation, m_inverseDeviation);
+		return true;
+	}
+	void Standardize::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_count);
+		params.push_back(m_mean);
+		params.push_back(m_m2);
+	}
+	void Standardize::setParameters(const std::vector<double>& params) {
+		assert(params.size() == 3);
+		m_count = params[0];
+		m_mean = params[1];
+		m_m2 = params[2];
+		updateCoefficients();
+	}
+	const std::string& Standardize::getTypeName() const {
+		return m_name;
+	}
+	Scaler* Standardize::clone() const {
+		return new Standardize(*this);
+	}
+	void Standardize::merge(const Scaler& other) {
+		checkMergeable(other);
+		const Standardize& o = static_cast<const Standardize&>(other);
+		combine(o.m_count, o.m_mean, o.m_m2);
+		m_missingCount += o.m_missingCount;
+		updateCoefficients();
+	}
+	bool Standardize::setMissingValuePolicy(MissingValuePolicy policy, double imputedValue) {
+		m_missingPolicy = policy;
+		m_imputedValue = imputedValue;
+		return true;
+	}
+	MissingValuePolicy Standardize::getMissingValuePolicy(double& imputedValue) const {
+		imputedValue = m_imputedValue;
+		return m_missingPolicy;
+	}
+	size_t Standardize::getMissingCount() const {
+		return m_missingCount;
+	}
+	double Standardize::getMean() const {
+		return m_mean;
+	}
+	double Standardize::getDeviation() const {
+		return (m_count > 0.0) ? sqrt(m_m2/m_count) : 0.0;
+	}
+}
@@ -0,0 +1,407 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+#include <pulse/TransformedNormalize.h>
+#include "ScalingHelpers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <stdint.h>
+
+namespace pulse {
+	namespace {
+		using detail::StridedAccessor;
+		using detail::StridedOutput;
+		using detail::RowAccessor;
+		
+		/** data[i], lets the compiler vectorize without checking the offsets */
+		struct ContiguousInput {
+			ContiguousInput(double const* data) : data(data) {}
+			inline double operator()(size_t i) const {
+				return data[i];
+			}
+			double const* data;
+		};
+		/** data[i] */
+		struct ContiguousOutput {
+			ContiguousOutput(double* data) : data(data) {}
+			inline double& operator()(size_t i) const {
+				return data[i];
+			}
+			double* data;
+		};
+		
+		const double ln2Hi = 6.93147180369123816490e-01;
+		const double ln2Lo = 1.90821492927058770002e-10;
+		const double inverseLn2 = 1.44269504088896338700e+00;
+		/** adding and subtracting it rounds to an integer, the integer is in the low bits of the sum */
+		const double roundingConstant = 6755399441055744.0;
+		
+		inline uint64_t toBits(double value) {
+			uint64_t re;
+			memcpy(&re, &value, sizeof(re));
+			return re;
+		}
+		inline double fromBits(uint64_t bits) {
+			double re;
+			memcpy(&re, &bits, sizeof(re));
+			return re;
+		}
+		/** condition ? a : b with bit masks, a ?: on doubles is not vectorized by gcc with the default -ftrapping-math */
+		inline double select(bool condition, double a, double b) {
+			const uint64_t mask = static_cast<uint64_t>(0) - static_cast<uint64_t>(condition);
+			return fromBits((toBits(a) & mask) | (toBits(b) & ~mask));
+		}
+		/** value with the sign of sign, without a library call */
+		inline double withSign(double value, double sign) {
+			const uint64_t signBit = 0x8000000000000000ULL;
+			return fromBits((toBits(value) & ~signBit) | (toBits(sign) & signBit));
+		}
+		/** log(z) for z > 0: z = m*2^e with m in [sqrt(0.5), sqrt(2)), log(m) = 2*atanh((m-1)/(m+1)) as odd series.
+		 *  Only integer and floating point operations without conversions between them, so SSE2 is enough to vectorize it.
+		 */
+		inline double fastLog(double z) {
+			const uint64_t bits = toBits(z);
+			//biased exponent of z, rounded up if the mantissa is >= sqrt(2)
+			const uint64_t biased = (bits + (0x3ff0000000000000ULL - 0x3fe6a09e667f3bcdULL)) >> 52;
+			const double e = fromBits(biased | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0);
+			const double m = fromBits(bits - (biased << 52) + 0x3ff0000000000000ULL);
+			const double s = (m-1.0)/(m+1.0);
+			const double s2 = s*s;
+			//2*(1 + s2/3 + s2^2/5 + ... + s2^8/17)
+			double p = 2.0/17.0;
+			p = p*s2 + 2.0/15.0;
+			p = p*s2 + 2.0/13.0;
+			p = p*s2 + 2.0/11.0;
+			p = p*s2 + 2.0/9.0;
+			p = p*s2 + 2.0/7.0;
+			p = p*s2 + 2.0/5.0;
+			p = p*s2 + 2.0/3.0;
+			p = p*s2 + 2.0;
+			double re = e*ln2Hi + (s*p + e*ln2Lo);
+			//infinity, NaN, 0 and negative values, selected without branches
+			re = select(z < std::numeric_limits<double>::infinity(), re, z);
+			const double invalid = select(z == 0.0, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN());
+			return select(z > 0.0 || z != z, re, invalid);
+		}
+		/** exp(t)-1 for 0 <= t <= 64: t = k*ln2 + r with |r| <= ln2/2, exp(t)-1 = 2^k*expm1(r) + 2^k - 1 */
+		inline double fastExpm1(double t) {
+			const double shifted = t*inverseLn2 + roundingConstant;
+			const double k = shifted - roundingConstant;
+			const double r = (t - k*ln2Hi) - k*ln2Lo;
+			//2^k from the low bits of shifted
+			const double twoPowK = fromBits((toBits(shifted) + 1023) << 52);
+			//Taylor series of expm1(r) up to r^12/12!
+			double p = 1.0/479001600.0;
+			p = p*r + 1.0/39916800.0;
+			p = p*r + 1.0/3628800.0;
+			p = p*r + 1.0/362880.0;
+			p = p*r + 1.0/40320.0;
+			p = p*r + 1.0/5040.0;
+			p = p*r + 1.0/720.0;
+			p = p*r + 1.0/120.0;
+			p = p*r + 1.0/24.0;
+			p = p*r + 1.0/6.0;
+			p = p*r + 0.5;
+			p = p*r + 1.0;
+			return twoPowK*(p*r) + (twoPowK - 1.0);
+		}
+		/** tanh(|x|) = expm1(2|x|)/(expm1(2|x|)+2), tanh(20) is 1 in double precision, NaN stays NaN */
+		inline double fastTanh(double x) {
+			const double a = fabs(x);
+			const double e = fastExpm1(2.0*select(a > 20.0, 20.0, a));
+			return withSign(e/(e+2.0), x);
+		}
+		
+		/** Number of values that are transformed together in a buffer */
+		const size_t bufferSize = 256;
+	}
+	
+	double Log1pTransform::apply(double x) {
+		return log1p(x);
+	}
+	double Log1pTransform::applyFast(double x) {
+		//1+x is exact for x in [-1,-0.5], elsewhere its rounding error is below the error of the result
+		return fastLog(1.0 + x);
+	}
+	void Log1pTransform::applyFast(double* values, size_t num) {
+		for (size_t i = 0; i < num; i++) {
+			values[i] = fastLog(1.0 + values[i]);
+		}
+	}
+	double Log1pTransform::invert(double y) {
+		return expm1(y);
+	}
+	void Log1pTransform::getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high) {
+		inScale = 1.0;
+		inOffset = 0.0;
+		low = apply(min);
+		high = apply(max);
+	}
+	const char* Log1pTransform::name() {
+		return "Log1pNormalize";
+	}
+	
+	double SignedLogTransform::apply(double x) {
+		return copysign(log1p(fabs(x)), x);
+	}
+	double SignedLogTransform::applyFast(double x) {
+		return withSign(fastLog(1.0 + fabs(x)), x);
+	}
+	void SignedLogTransform::applyFast(double* values, size_t num) {
+		for (size_t i = 0; i < num; i++) {
+			values[i] = withSign(fastLog(1.0 + fabs(values[i])), values[i]);
+		}
+	}
+	double SignedLogTransform::invert(double y) {
+		return copysign(expm1(fabs(y)), y);
+	}
+	void SignedLogTransform::getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high) {
+		inScale = 1.0;
+		inOffset = 0.0;
+		low = apply(min);
+		high = apply(max);
+	}
+	const char* SignedLogTransform::name() {
+		return "SignedLogNormalize";
+	}
+	
+	double TanhTransform::apply(double x) {
+		return tanh(x);
+	}
+	double TanhTransform::applyFast(double x) {
+		return fastTanh(x);
+	}
+	void TanhTransform::applyFast(double* values, size_t num) {
+		for (size_t i = 0; i < num; i++) {
+			values[i] = fastTanh(values[i]);
+		}
+	}
+	double TanhTransform::invert(double y) {
+		return atanh(y);
+	}
+	void TanhTransform::getRange(double min, double max, double& inScale, double& inOffset, double& low, double& high) {
+		inScale = 2.0/(max-min);
+		inOffset = -(min+max)/(max-min);
+		low = -1.0;
+		high = 1.0;
+	}
+	const char* TanhTransform::name() {
+		return "TanhNormalize";
+	}
+	
+	template<class Transform>
+	std::string TransformedNormalize<Transform>::m_name = std::string(Transform::name());
+	
+	template<class Transform>
+	TransformedNormalize<Transform>::TransformedNormalize(double minNorm, double maxNorm, bool exact) :
+		m_min(0.0),
+		m_max(1.0),
+		m_minNorm(minNorm),
+		m_maxNorm(maxNorm),
+		m_exact(exact)
+	{
+		assert(minNorm < maxNorm);
+		updateRange();
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::updateRange() {
+		//make sure that m_min < m_max (same as Normalize)
+		if (m_max - m_min == 0.0) {
+			m_max = m_max + m_max*m_max + 1.0;
+		}
+		double high;
+		Transform::getRange(m_min, m_max, m_inScale, m_inOffset, m_low, high);
+		m_factor = (m_maxNorm-m_minNorm)/(high-m_low);
+	}
+	template<class Transform>
+	template<class Input, class Output>
+	void TransformedNormalize<Transform>::transform(const Input& in, const Output& out, size_t num) const {
+		const double inScale = m_inScale;
+		const double inOffset = m_inOffset;
+		const double low = m_low;
+		const double factor = m_factor;
+		const double minNorm = m_minNorm;
+		if (m_exact) {
+			for (size_t i = 0; i < num; i++) {
+				out(i) = (Transform::apply(in(i)*inScale + inOffset) - low)*factor + minNorm;
+			}
+		} else {
+			//the values are copied to a buffer, so the transform is a vectorized loop for every kind of input
+			double buffer[bufferSize];
+			for (size_t first = 0; first < num; first += bufferSize) {
+				const size_t count = std::min(bufferSize, num - first);
+				for (size_t i = 0; i < count; i++) {
+					buffer[i] = in(first+i)*inScale + inOffset;
+				}
+				Transform::applyFast(buffer, count);
+				for (size_t i = 0; i < count; i++) {
+					out(first+i) = (buffer[i] - low)*factor + minNorm;
+				}
+			}
+		}
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::updateScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		double min = m_min;
+		double max = m_max;
+		for (size_t i = 0; i < num; i++) {
+			min = std::min(min, data[i*offset]);
+			max = std::max(max, data[i*offset]);
+		}
+		m_min = min;
+		m_max = max;
+		updateRange();
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::updateScalingFactors(double** const data, size_t offset, size_t num) {
+		double min = m_min;
+		double max = m_max;
+		for (size_t i = 0; i < num; i++) {
+			min = std::min(min, data[i][offset]);
+			max = std::max(max, data[i][offset]);
+		}
+		m_min = min;
+		m_max = max;
+		updateRange();
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::updateScalingFactors(double value) {
+		m_min = std::min(m_min, value);
+		m_max = std::max(m_max, value);
+		updateRange();
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::resetScalingFactors(double const* data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_min = std::numeric_limits<double>::infinity();
+		m_max = -std::numeric_limits<double>::infinity();
+		updateScalingFactors(data, offset, num);
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::resetScalingFactors(double** const data, size_t offset, size_t num) {
+		assert(num > 0);
+		m_min = std::numeric_limits<double>::infinity();
+		m_max = -std::numeric_limits<double>::infinity();
+		updateScalingFactors(data, offset, num);
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::scale(double const* in, int inOffset, double* out, size_t outOffset, size_t num) const {
+		if (inOffset == 1 && outOffset == 1) {
+			transform(ContiguousInput(in), ContiguousOutput(out), num);
+		} else {
+			transform(StridedAccessor(in, inOffset), StridedOutput(out, outOffset), num);
+		}
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::scale(double** data, size_t offset, size_t num) const {
+		transform(RowAccessor(data, offset), RowAccessor(data, offset), num);
+	}
+	template<class Transform>
+	double TransformedNormalize<Transform>::scale(double value) const {
+		const double x = value*m_inScale + m_inOffset;
+		const double y = m_exact ? Transform::apply(x) : Transform::applyFast(x);
+		return (y - m_low)*m_factor + m_minNorm;
+	}
+	template<class Transform>
+	double TransformedNormalize<Transform>::originalValue(double value) const {
+		return (Transform::invert((value - m_minNorm)/m_factor + m_low) - m_inOffset)/m_inScale;
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::getParameters(std::vector<double>& params) const {
+		assert(params.empty());
+		params.push_back(m_min);
+		params.push_back(m_max);
+		params.push_back(m_minNorm);
+		params.push_back(m_maxNorm);
+		params.push_back(m_exact ? 1.0 : 0.0);
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::setParameters(const std::vector<double>& params) {
+		assert(params.size() == 5);
+		m_min = params[0];
+		m_max = params[1];
+		m_minNorm = params[2];
+		m_maxNorm = params[3];
+		m_exact = (params[4] != 0.0);
+		assert(m_minNorm < m_maxNorm);
+		updateRange();
+	}
+	template<class Transform>
+	const std::string& TransformedNormalize<Transform>::getTypeName() const {
+		return m_name;
+	}
+	template<class Transform>
+	Scaler* TransformedNormalize<Transform>::clone() const {
+		return new TransformedNormalize<Transform>(*this);
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::merge(const Scaler& other) {
+		checkMergeable(other);
+		const TransformedNormalize<Transform>& o = static_cast<const TransformedNormalize<Transform>&>(other);
+		if (o.m_exact != m_exact) {
+			throw MergeException(getTypeName() + " scalers with different precisions can not be merged");
+		}
+		m_min = std::min(m_min, o.m_min);
+		m_max = std::max(m_max, o.m_max);
+		updateRange();
+	}
+	template<class Transform>
+	bool TransformedNormalize<Transform>::isExtremaSufficient() const {
+		return true;
+	}
+	template<class Transform>
+	bool TransformedNormalize<Transform>::getNormRange(double& minNorm, double& maxNorm) const {
+		minNorm = m_minNorm;
+		maxNorm = m_maxNorm;
+		return true;
+	}
+	template<class Transform>
+	bool TransformedNormalize<Transform>::isExact() const {
+		return m_exact;
+	}
+	template<class Transform>
+	void TransformedNormalize<Transform>::setExact(bool exact) {
+		m_exact = exact;
+	}
+	
+	template class TransformedNormalize<Log1pTransform>;
+	template class TransformedNormalize<SignedLogTransform>;
+	template class TransformedNormalize<TanhTransform>;
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* pulse_codegen - turns a file written by PatternScaler::saveToFile into a C++ header
+ * with constexpr scaling parameters (see pulse::ScalerHeaderGenerator).
+ *
+ * usage: pulse_codegen <scaler file> <header file> [namespace]
+ */
+
+#include <pulse/ScalerHeaderGenerator.h>
+
+#include <iostream>
+#include <exception>
+
+int main(int argc, char** argv) {
+	if (argc < 3 || argc > 4) {
+		std::cerr<<"usage: "<<argv[0]<<" <scaler file> <header file> [namespace]"<<std::endl;
+		return 1;
+	}
+	std::string ns = (argc == 4) ? std::string(argv[3]) : std::string("pulse_generated");
+	try {
+		pulse::ScalerHeaderGenerator generator(argv[1]);
+		generator.writeToFile(argv[2], ns);
+	} catch (std::exception& e) {
+		std::cerr<<argv[0]<<": "<<e.what()<<std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ 
+ Copyright (c) 2012, Julian Schmid,
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ - Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ - Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ - Neither the name of Julian Schmid nor the names of its
+ contributors may be used to endorse or promote products derived from this
+ software without specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ 
+ ****************************************************************************/
+
+
+/* pulse_merge - merges files written by PatternScaler::saveToFile that were fitted
+ * on different shards of the data into one file (see pulse::PatternScaler::merge).
+ *
+ * usage: pulse_merge <output file> <scaler file> [<scaler file> ...]
+ */
+
+#include <pulse/PatternScaler.h>
+
+#include <iostream>
+#include <exception>
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr<<"usage: "<<argv[0]<<" <output file> <scaler file> [<scaler file> ...]"<<std::endl;
+		return 1;
+	}
+	try {
+		pulse::PatternScaler merged;
+		merged.loadFromFile(argv[2]);
+		for (int i = 3; i < argc; i++) {
+			pulse::PatternScaler shard;
+			shard.loadFromFile(argv[i]);
+			if (shard.numInputDimensions() != merged.numInputDimensions() || shard.numTargetDimensions() != merged.numTargetDimensions()) {
+				std::cerr<<argv[0]<<": "<<argv[i]<<" has different dimensions than "<<argv[2]<<std::endl;
+				return 1;
+			}
+			try {
+				merged.merge(shard);
+			} catch (pulse::MergeException& e) {
+				std::cerr<<argv[0]<<": can not merge "<<argv[i]<<" into "<<argv[2]<<": "<<e.what()<<std::endl;
+				return 1;
+			}
+		}
+		merged.saveToFile(argv[1]);
+	} catch (std::exception& e) {
+		std::cerr<<argv[0]<<": "<<e.what()<<std::endl;
+		return 1;
+	}
+	return 0;
+}